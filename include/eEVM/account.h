@@ -64,6 +64,27 @@ namespace eevm
     virtual Code get_code() const = 0;
     virtual void set_code(Code&& code) = 0;
 
+    virtual size_t get_code_size() const
+    {
+      return get_code().size();
+    }
+
+    /// Keccak-256 hash of the code. This default hashes a copy of the code,
+    /// so implementations which hold the hash should return it instead.
+    virtual uint256_t get_code_hash() const
+    {
+      return from_big_endian(keccak_256(get_code()).data());
+    }
+
+    /// Whether get_code_hash is cheap, because the account holds the hash
+    /// rather than computing it. Implementations which override
+    /// get_code_hash to return a held hash should return true here, so that
+    /// code can be found by its hash on every call.
+    virtual bool holds_code_hash() const
+    {
+      return false;
+    }
+
     virtual bool has_code()
     {
       return !get_code().empty();
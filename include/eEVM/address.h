@@ -4,10 +4,107 @@
 #pragma once
 #include "bigint.h"
 
+#include <array>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
 namespace eevm
 {
-  // NOTE: Addresses will only use the low 160-bits, but it is simpler to use
-  // overloads to serialise/pass these as any other 256-bit value. This is how
-  // they are stored in EVM bytecode/memory.
-  using Address = uint256_t;
-}
+  /**
+   * A 160-bit account address, held as its 20 big-endian bytes. It is the key
+   * of state maps and logs, so is kept to the size of an address rather than
+   * of a word, and compares bytewise.
+   *
+   * EVM bytecode handles addresses as words, so an Address converts to and
+   * from uint256_t. Conversion from a word keeps its low 160 bits.
+   */
+  class Address
+  {
+  public:
+    static constexpr size_t SIZE = 20;
+
+  private:
+    std::array<uint8_t, SIZE> bytes = {};
+
+  public:
+    constexpr Address() = default;
+
+    Address(const uint256_t& v)
+    {
+      uint8_t word[32];
+      intx::be::unsafe::store(word, v);
+      std::memcpy(bytes.data(), word + 32 - SIZE, SIZE);
+    }
+
+    template <
+      typename T,
+      typename = std::enable_if_t<std::is_integral<T>::value>>
+    Address(T v) : Address(uint256_t(v))
+    {}
+
+    operator uint256_t() const
+    {
+      uint8_t word[32] = {};
+      std::memcpy(word + 32 - SIZE, bytes.data(), SIZE);
+      return intx::be::unsafe::load<uint256_t>(word);
+    }
+
+    const uint8_t* data() const
+    {
+      return bytes.data();
+    }
+
+    /// low 64 bits, which are as well mixed as any others
+    uint64_t low64() const
+    {
+      uint64_t v = 0;
+      for (size_t i = SIZE - sizeof(v); i < SIZE; ++i)
+        v = (v << 8) | bytes[i];
+      return v;
+    }
+
+    // Bytes are big-endian, so bytewise order is numeric order
+    friend bool operator==(const Address& l, const Address& r)
+    {
+      return l.bytes == r.bytes;
+    }
+
+    friend bool operator!=(const Address& l, const Address& r)
+    {
+      return l.bytes != r.bytes;
+    }
+
+    friend bool operator<(const Address& l, const Address& r)
+    {
+      return std::memcmp(l.bytes.data(), r.bytes.data(), SIZE) < 0;
+    }
+
+    friend bool operator>(const Address& l, const Address& r)
+    {
+      return r < l;
+    }
+
+    friend bool operator<=(const Address& l, const Address& r)
+    {
+      return !(r < l);
+    }
+
+    friend bool operator>=(const Address& l, const Address& r)
+    {
+      return !(l < r);
+    }
+  };
+} // namespace eevm
+
+namespace std
+{
+  template <>
+  struct hash<eevm::Address>
+  {
+    size_t operator()(const eevm::Address& a) const
+    {
+      return static_cast<size_t>(a.low64());
+    }
+  };
+} // namespace std
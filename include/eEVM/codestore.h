@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "account.h"
+#include "bigint.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace eevm
+{
+  /**
+   * Bytecode held in a CodeStore, with its Keccak-256 hash
+   */
+  struct StoredCode
+  {
+    const Code code;
+    const uint256_t hash;
+  };
+
+  using SharedCode = std::shared_ptr<const StoredCode>;
+
+  /**
+   * Process-wide, content-addressed store of bytecode. Accounts holding
+   * identical code (eg, thousands of clones of one contract) share a single
+   * copy of it, which is hashed once when first stored. Code is reference
+   * counted, and dropped from the store once no account holds it.
+   *
+   * The store is safe to use from multiple threads.
+   */
+  class CodeStore
+  {
+  private:
+    struct CodeHash
+    {
+      size_t operator()(const uint256_t& h) const
+      {
+        // Keys are Keccak digests, so any of their bits are well mixed
+        return static_cast<size_t>(h.lo.lo);
+      }
+    };
+
+    std::mutex lock;
+    std::unordered_map<uint256_t, std::weak_ptr<const StoredCode>, CodeHash>
+      entries;
+
+    CodeStore() = default;
+    void release(const StoredCode* code);
+
+  public:
+    /// The process's store. It is never destroyed, so that code may outlive
+    /// any static object.
+    static CodeStore& instance();
+
+    /// The stored copy of code, which is added if not already held
+    SharedCode intern(Code&& code);
+
+    /// Number of distinct codes held
+    size_t size();
+  };
+
+  /// Keccak-256 hash of empty code
+  const uint256_t& empty_code_hash();
+} // namespace eevm
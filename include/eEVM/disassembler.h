@@ -5,6 +5,7 @@
 #include "bigint.h"
 #include "exception.h"
 #include "opcode.h"
+#include "opcodeinfo.h"
 #include "util.h"
 
 #include <algorithm>
@@ -98,19 +99,10 @@ namespace eevm
 
   struct Disassembler
   {
-    const static std::unordered_map<uint8_t, Op> ops;
-
     static Op getOp(Opcode oc)
     {
-      const auto op_it = ops.find(oc);
-      if (op_it == ops.end())
-      {
-        return Op(oc, "INVALID");
-      }
-      else
-      {
-        return op_it->second;
-      }
+      const auto& info = op_info(oc);
+      return Op(oc, info.mnemonic, info.immediate_bytes, info.gas);
     }
 
     static Disassembly dis(const std::vector<uint8_t>& prog)
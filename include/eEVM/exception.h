@@ -2,10 +2,64 @@
 // Licensed under the MIT License.
 
 #pragma once
+#include <cstdint>
 #include <exception>
+#include <fmt/format_header_only.h>
+#include <string>
+#include <utility>
 
 namespace eevm
 {
+  /**
+   * Message of an Exception. Messages of faults raised by the VM are held as
+   * a static format and its numeric operands, so that they can be created,
+   * copied and stored without allocating, and are formatted only when read.
+   */
+  class ErrorMessage
+  {
+    /// format, with a {} for each operand used
+    const char* format = nullptr;
+    uint64_t operands[6] = {};
+    /// message given as text, rather than as a format
+    std::string text;
+
+  public:
+    ErrorMessage() = default;
+    ErrorMessage(const std::string& text) : text(text) {}
+
+    /// format must have static storage duration
+    ErrorMessage(
+      const char* format,
+      uint64_t a,
+      uint64_t b,
+      uint64_t c,
+      uint64_t d,
+      uint64_t e,
+      uint64_t f) :
+      format(format),
+      operands{a, b, c, d, e, f}
+    {}
+
+    uint64_t operand(size_t i) const
+    {
+      return operands[i];
+    }
+
+    std::string str() const
+    {
+      if (!format)
+        return text;
+      return fmt::format(
+        format,
+        operands[0],
+        operands[1],
+        operands[2],
+        operands[3],
+        operands[4],
+        operands[5]);
+    }
+  };
+
   /**
    * A smart contract runtime execption
    */
@@ -24,15 +78,58 @@ namespace eevm
     const Type type;
 
   private:
-    const std::string msg;
+    const ErrorMessage message;
+    /// message, once formatted for what()
+    mutable std::string formatted;
+    mutable bool is_formatted = false;
 
   public:
-    Exception(Type t, const std::string& m) : type(t), msg(m) {}
+    Exception(Type t, const std::string& m) : type(t), message(m) {}
+
+    /**
+     * @brief A fault raised by the VM, which is cheap to raise because it
+     * neither allocates nor formats. Its message is formatted only if what()
+     * is called.
+     *
+     * @param format must have static storage duration
+     */
+    static Exception fault(
+      Type t,
+      const char* format,
+      uint64_t a = 0,
+      uint64_t b = 0,
+      uint64_t c = 0,
+      uint64_t d = 0,
+      uint64_t e = 0,
+      uint64_t f = 0)
+    {
+      return Exception(t, ErrorMessage(format, a, b, c, d, e, f));
+    }
+
+    const ErrorMessage& get_message() const
+    {
+      return message;
+    }
 
     const char* what() const noexcept override
     {
-      return msg.c_str();
+      if (!is_formatted)
+      {
+        try
+        {
+          formatted = message.str();
+        }
+        catch (...)
+        {
+          return "Exception (message could not be formatted)";
+        }
+        is_formatted = true;
+      }
+      return formatted.c_str();
     }
+
+  private:
+    Exception(Type t, ErrorMessage&& m) : type(t), message(std::move(m)) {}
   };
 
   /**
@@ -0,0 +1,46 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "opcode.h"
+
+#include <cstdint>
+
+namespace eevm
+{
+  /**
+   * Ethereum hard forks whose instruction sets eEVM can execute. Opcodes
+   * introduced after the selected fork are rejected, exactly as unknown
+   * opcodes are.
+   */
+  enum class Fork : uint8_t
+  {
+    homestead = 0,
+    byzantium, // RETURNDATASIZE, RETURNDATACOPY, STATICCALL, REVERT
+    constantinople, // SHL, SHR, SAR, CREATE2, EXTCODEHASH
+
+    latest = constantinople
+  };
+
+  /// The first fork in which the given opcode is valid
+  constexpr Fork introduced_in(Opcode op)
+  {
+    switch (op)
+    {
+      case RETURNDATASIZE:
+      case RETURNDATACOPY:
+      case STATICCALL:
+      case REVERT:
+        return Fork::byzantium;
+      case SHL:
+      case SHR:
+      case SAR:
+      case CREATE2:
+      case EXTCODEHASH:
+        return Fork::constantinople;
+      default:
+        return Fork::homestead;
+    }
+  }
+} // namespace eevm
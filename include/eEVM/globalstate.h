@@ -5,6 +5,7 @@
 
 #include "account.h"
 #include "block.h"
+#include "codestore.h"
 #include "storage.h"
 
 #include <map>
@@ -38,9 +39,52 @@ namespace eevm
 
     /**
      * Creates a new zero-initialized account under the given address if none
-     * exists
+     * exists. This is for writes: reads should use find, or the queries
+     * below, so that looking at an address does not create an account there.
      */
     virtual AccountState get(const Address& addr) = 0;
+    /**
+     * Whether an account exists under the given address. Implementations
+     * should override this so that, unlike get, it never creates one. This
+     * default can only ask get, so it creates an empty account where there
+     * was none, and reports an empty account as not existing, which is how
+     * the EVM treats empty accounts from Spurious Dragon (EIP-161).
+     */
+    virtual bool exists(const Address& addr)
+    {
+      const auto& acc = get(addr).acc;
+      return acc.get_nonce() != 0 || acc.get_balance() != 0 ||
+        acc.get_code_size() != 0;
+    }
+    /**
+     * The account under the given address, or nullptr if none exists. Like
+     * exists, this never creates one. This default looks the address up
+     * twice, so implementations should override it with a single lookup.
+     */
+    virtual const Account* find(const Address& addr)
+    {
+      return exists(addr) ? &get(addr).acc : nullptr;
+    }
+
+    /// Read-only queries, under which an address with no account reads as
+    /// an empty one
+    uint256_t get_balance(const Address& addr)
+    {
+      const auto acc = find(addr);
+      return acc ? acc->get_balance() : 0;
+    }
+
+    size_t get_code_size(const Address& addr)
+    {
+      const auto acc = find(addr);
+      return acc ? acc->get_code_size() : 0;
+    }
+
+    uint256_t get_code_hash(const Address& addr)
+    {
+      const auto acc = find(addr);
+      return acc ? acc->get_code_hash() : empty_code_hash();
+    }
     virtual AccountState create(
       const Address& addr, const uint256_t& balance, const Code& code) = 0;
 
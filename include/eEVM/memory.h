@@ -0,0 +1,94 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+
+namespace eevm
+{
+  /**
+   * Memory of an execution context, used by Processor. It grows in whole
+   * words, reads as zero wherever it has not been written, and tracks the gas
+   * cost of its expansion.
+   *
+   * Capacity grows geometrically, so expanding a word at a time does not copy
+   * the whole buffer each time. Large buffers are mapped from the OS's zero
+   * pages, so that they need no explicit zero-filling and pages which are
+   * never touched are never backed.
+   */
+  class Memory
+  {
+  private:
+    uint8_t* buf = nullptr;
+    /// bytes in use, always a whole number of words
+    uint64_t used = 0;
+    /// bytes allocated. Bytes beyond used have never been written.
+    uint64_t capacity = 0;
+    /// whether buf is mapped, rather than allocated from the heap
+    bool mapped = false;
+    /// expansion cost of the words in use
+    uint64_t gas = 0;
+
+    void grow(uint64_t end);
+    void reserve(uint64_t n);
+    void release();
+
+  public:
+    static constexpr uint64_t WORD_SIZE = 32;
+    /// smallest allocation, so that early growth is not word by word
+    static constexpr uint64_t MIN_CAPACITY = 1024;
+    /// allocations of at least this many bytes are mapped from zero pages
+    static constexpr uint64_t MAP_THRESHOLD = 64 * 1024;
+
+    Memory() = default;
+    Memory(const Memory&) = delete;
+    Memory& operator=(const Memory&) = delete;
+    Memory(Memory&& other) noexcept;
+    Memory& operator=(Memory&& other) noexcept;
+    ~Memory();
+
+    /**
+     * Make bytes [0, end) addressable, growing to the next whole word if
+     * necessary. Bounds (and overflow of end) are the caller's to check.
+     */
+    void expand(uint64_t end)
+    {
+      if (end > used)
+        grow(end);
+    }
+
+    uint8_t* data()
+    {
+      return buf;
+    }
+
+    const uint8_t* data() const
+    {
+      return buf;
+    }
+
+    uint8_t& operator[](uint64_t i)
+    {
+      return buf[i];
+    }
+
+    /// size in bytes, always a whole number of words
+    uint64_t size() const
+    {
+      return used;
+    }
+
+    uint64_t words() const
+    {
+      return used / WORD_SIZE;
+    }
+
+    /// gas cost of expanding to the current size: 3 per word, plus the
+    /// square of the words over 512
+    uint64_t cost() const
+    {
+      return gas;
+    }
+  };
+} // namespace eevm
@@ -0,0 +1,153 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "address.h"
+#include "fork.h"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace eevm
+{
+  /**
+   * Non-owning, read-only view of a contiguous range of bytes
+   */
+  class ByteView
+  {
+    const uint8_t* ptr = nullptr;
+    size_t len = 0;
+
+  public:
+    ByteView() = default;
+    ByteView(const uint8_t* data, size_t size) : ptr(data), len(size) {}
+    ByteView(const std::vector<uint8_t>& v) : ptr(v.data()), len(v.size()) {}
+
+    const uint8_t* data() const
+    {
+      return ptr;
+    }
+
+    size_t size() const
+    {
+      return len;
+    }
+
+    bool empty() const
+    {
+      return len == 0;
+    }
+
+    const uint8_t* begin() const
+    {
+      return ptr;
+    }
+
+    const uint8_t* end() const
+    {
+      return ptr + len;
+    }
+
+    uint8_t operator[](size_t i) const
+    {
+      return ptr[i];
+    }
+  };
+
+  /**
+   * Destination for a native contract's output. Bytes are collected in a
+   * buffer, and only copied to the output region of the caller's memory once
+   * the contract has returned, so a contract which fails leaves that region
+   * untouched, and one whose input and output overlap reads its input intact.
+   */
+  class NativeOutput
+  {
+    std::vector<uint8_t>& buf;
+
+  public:
+    explicit NativeOutput(std::vector<uint8_t>& buf) : buf(buf) {}
+
+    /// Appends bytes to the output
+    void write(ByteView bytes);
+
+    /// Total bytes written
+    size_t size() const
+    {
+      return buf.size();
+    }
+
+    const uint8_t* data() const
+    {
+      return buf.data();
+    }
+  };
+
+  /**
+   * A contract implemented natively rather than in EVM bytecode. Calls to
+   * its address run it synchronously, in the caller's context.
+   */
+  class NativeContract
+  {
+  public:
+    virtual ~NativeContract() = default;
+
+    /**
+     * @brief Gas required to execute the contract on this input. If this
+     * exceeds the gas passed to the call, the call fails without executing.
+     */
+    virtual uint64_t gas(ByteView input) const = 0;
+
+    /**
+     * @brief Runs the contract.
+     *
+     * Input is a view of the caller's memory, valid only for the duration of
+     * this call. Throwing an eevm::Exception fails the call, as if the callee
+     * had thrown, and discards anything already written.
+     */
+    virtual void execute(ByteView input, NativeOutput& output) = 0;
+  };
+
+  /// Stateless native contract body, returning its output
+  using NativeFunction = std::function<std::vector<uint8_t>(ByteView input)>;
+  using NativeGasFunction = std::function<uint64_t(ByteView input)>;
+
+  /**
+   * Registry mapping addresses to native contracts
+   */
+  class NativeContracts
+  {
+    std::map<Address, std::shared_ptr<NativeContract>> contracts;
+
+  public:
+    /// Highest address of the standard precompiles in the given fork. Below
+    /// Byzantium, only 0x01-0x04 exist, and later addresses are plain
+    /// accounts. blake2f (0x09) arrived in Istanbul, later than any fork
+    /// Processor supports, so is only run if registered by hand.
+    static constexpr uint64_t max_standard_address(Fork fork)
+    {
+      return fork < Fork::byzantium ? 4 : 8;
+    }
+
+    NativeContracts() = default;
+
+    /// Registry containing the standard precompiles of the given fork
+    static NativeContracts standard(Fork fork = Fork::latest);
+
+    /// Adds (or replaces) the contract at the given address
+    void add(const Address& addr, std::shared_ptr<NativeContract> contract);
+
+    /// Adds a contract made from a pair of functions. If gas is empty, the
+    /// contract costs nothing to call.
+    void add(
+      const Address& addr, NativeFunction execute, NativeGasFunction gas = {});
+
+    bool remove(const Address& addr);
+
+    /// Returns nullptr if there is no contract at the given address
+    NativeContract* find(const Address& addr) const;
+  };
+} // namespace eevm
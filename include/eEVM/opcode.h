@@ -7,9 +7,9 @@
 namespace eevm
 {
   /**
-   * All opcodes supported by our EVM. Note that we currently target Homestead
-   * compliance, so we are missing some more recent additions
-   * (RETURNDATASIZE, RETURNDATACOPY, STATICCALL, REVERT, INVALID)
+   * All opcodes supported by our EVM, up to Constantinople. Those added after
+   * Homestead are only executed when the Processor targets a fork which
+   * includes them (see fork.h)
    */
   enum Opcode : uint8_t
   {
@@ -39,6 +39,9 @@ namespace eevm
     XOR    = 0x18, // Bitwise XOR operation
     NOT    = 0x19, // Bitwise NOT operation
     BYTE   = 0x1a, // Retrieve single byte from word
+    SHL    = 0x1b, // Shift left
+    SHR    = 0x1c, // Logical shift right
+    SAR    = 0x1d, // Arithmetic (signed) shift right
 
     // 20s: SHA3
     SHA3   = 0x20, // Compute Keccak-256 hash.
@@ -57,8 +60,9 @@ namespace eevm
     GASPRICE       = 0x3a, //  Get price of gas in current environment. (This is gas price specified by the originating transaction.)
     EXTCODESIZE    = 0x3b, // Get size of an account’s code.
     EXTCODECOPY    = 0x3c, // Copy an account’s code to memory
-    // RETURNDATASIZE = 0x3d, // Get size of output data from the previous call from the current environment.
-    // RETURNDATACOPY = 0x3e, // Copy output data from the previous call to memory.
+    RETURNDATASIZE = 0x3d, // Get size of output data from the previous call from the current environment.
+    RETURNDATACOPY = 0x3e, // Copy output data from the previous call to memory.
+    EXTCODEHASH    = 0x3f, // Get hash of an account’s code.
 
     // 40s: Block Information
     BLOCKHASH  = 0x40, // Get the hash of one of the 256 most recent complete blocks.
@@ -165,9 +169,10 @@ namespace eevm
     CALLCODE     = 0xf2, // Message-call into this account with an alternative account’s code
     RETURN       = 0xf3, // Halt execution returning output data
     DELEGATECALL = 0xf4, // Message-call into this account with an alternative account’s code, but persisting the current values for sender and value.
-    // STATICCALL   = 0xfa, // Static message-call into an account. Exactly equivalent to CALL except: The argument µs is replaced with 0.
-    // REVERT       = 0xfd, // Halt execution reverting state changes but returning data and remaining gas
-    // INVALID      = 0xfe, // Designated invalid instruction
+    CREATE2      = 0xf5, // Create a new account at an address derived from a salt and the init code
+    STATICCALL   = 0xfa, // Static message-call into an account. Exactly equivalent to CALL except: The argument µs is replaced with 0.
+    REVERT       = 0xfd, // Halt execution reverting state changes but returning data and remaining gas
+    INVALID      = 0xfe, // Designated invalid instruction
     SELFDESTRUCT = 0xff
   };
 } // namespace eevm
@@ -0,0 +1,218 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+#include "opcode.h"
+
+#include <array>
+#include <cstdint>
+
+namespace eevm
+{
+  /**
+   * Static facts about an opcode. These are held in a single table, indexed
+   * by opcode byte, which the interpreter, its analysis of programs, the
+   * disassembler and traces all read.
+   */
+  struct OpInfo
+  {
+    enum Flags : uint8_t
+    {
+      /// not a defined opcode. Executing it faults, as for INVALID.
+      undefined = 1 << 0,
+      /// ends execution of the context
+      terminator = 1 << 1,
+      /// JUMP or JUMPI
+      jump = 1 << 2,
+      /// reads the state of accounts (or calls them)
+      reads_state = 1 << 3,
+      /// modifies state, so is forbidden within a static call
+      writes_state = 1 << 4
+    };
+
+    const char* mnemonic = "INVALID";
+    /// bytes of immediate data following the opcode (for PUSHn)
+    uint8_t immediate_bytes = 0;
+    /// words popped from, and then pushed to, the stack
+    uint8_t stack_in = 0;
+    uint8_t stack_out = 0;
+    /// static gas cost, under the Constantinople schedule. Any dynamic part
+    /// of the cost (for memory, copies, storage or calls) is not included.
+    uint16_t gas = 0;
+    uint8_t flags = undefined | terminator;
+
+    constexpr bool has(Flags f) const
+    {
+      return (flags & f) != 0;
+    }
+  };
+
+  namespace detail
+  {
+#define EEVM_OP_IMM(op, imm, in, out, gas, flags) \
+  t[op] = {#op, imm, in, out, gas, static_cast<uint8_t>(flags)}
+#define EEVM_OP(op, in, out, gas, flags) EEVM_OP_IMM(op, 0, in, out, gas, flags)
+
+    constexpr std::array<OpInfo, 256> make_op_table()
+    {
+      constexpr auto terminator = OpInfo::terminator;
+      constexpr auto jump = OpInfo::jump;
+      constexpr auto reads_state = OpInfo::reads_state;
+      constexpr auto writes_state = OpInfo::writes_state;
+
+      std::array<OpInfo, 256> t{};
+      EEVM_OP(STOP, 0, 0, 0, terminator);
+      EEVM_OP(ADD, 2, 1, 3, 0);
+      EEVM_OP(MUL, 2, 1, 5, 0);
+      EEVM_OP(SUB, 2, 1, 3, 0);
+      EEVM_OP(DIV, 2, 1, 5, 0);
+      EEVM_OP(SDIV, 2, 1, 5, 0);
+      EEVM_OP(MOD, 2, 1, 5, 0);
+      EEVM_OP(SMOD, 2, 1, 5, 0);
+      EEVM_OP(ADDMOD, 3, 1, 8, 0);
+      EEVM_OP(MULMOD, 3, 1, 8, 0);
+      EEVM_OP(EXP, 2, 1, 10, 0);
+      EEVM_OP(SIGNEXTEND, 2, 1, 5, 0);
+      EEVM_OP(LT, 2, 1, 3, 0);
+      EEVM_OP(GT, 2, 1, 3, 0);
+      EEVM_OP(SLT, 2, 1, 3, 0);
+      EEVM_OP(SGT, 2, 1, 3, 0);
+      EEVM_OP(EQ, 2, 1, 3, 0);
+      EEVM_OP(ISZERO, 1, 1, 3, 0);
+      EEVM_OP(AND, 2, 1, 3, 0);
+      EEVM_OP(OR, 2, 1, 3, 0);
+      EEVM_OP(XOR, 2, 1, 3, 0);
+      EEVM_OP(NOT, 1, 1, 3, 0);
+      EEVM_OP(BYTE, 2, 1, 3, 0);
+      EEVM_OP(SHL, 2, 1, 3, 0);
+      EEVM_OP(SHR, 2, 1, 3, 0);
+      EEVM_OP(SAR, 2, 1, 3, 0);
+      EEVM_OP(SHA3, 2, 1, 30, 0);
+      EEVM_OP(ADDRESS, 0, 1, 2, 0);
+      EEVM_OP(BALANCE, 1, 1, 400, reads_state);
+      EEVM_OP(ORIGIN, 0, 1, 2, 0);
+      EEVM_OP(CALLER, 0, 1, 2, 0);
+      EEVM_OP(CALLVALUE, 0, 1, 2, 0);
+      EEVM_OP(CALLDATALOAD, 1, 1, 3, 0);
+      EEVM_OP(CALLDATASIZE, 0, 1, 2, 0);
+      EEVM_OP(CALLDATACOPY, 3, 0, 3, 0);
+      EEVM_OP(CODESIZE, 0, 1, 2, 0);
+      EEVM_OP(CODECOPY, 3, 0, 3, 0);
+      EEVM_OP(GASPRICE, 0, 1, 2, 0);
+      EEVM_OP(EXTCODESIZE, 1, 1, 700, reads_state);
+      EEVM_OP(EXTCODECOPY, 4, 0, 700, reads_state);
+      EEVM_OP(RETURNDATASIZE, 0, 1, 2, 0);
+      EEVM_OP(RETURNDATACOPY, 3, 0, 3, 0);
+      EEVM_OP(EXTCODEHASH, 1, 1, 400, reads_state);
+      EEVM_OP(BLOCKHASH, 1, 1, 20, 0);
+      EEVM_OP(COINBASE, 0, 1, 2, 0);
+      EEVM_OP(TIMESTAMP, 0, 1, 2, 0);
+      EEVM_OP(NUMBER, 0, 1, 2, 0);
+      EEVM_OP(DIFFICULTY, 0, 1, 2, 0);
+      EEVM_OP(GASLIMIT, 0, 1, 2, 0);
+      EEVM_OP(POP, 1, 0, 2, 0);
+      EEVM_OP(MLOAD, 1, 1, 3, 0);
+      EEVM_OP(MSTORE, 2, 0, 3, 0);
+      EEVM_OP(MSTORE8, 2, 0, 3, 0);
+      EEVM_OP(SLOAD, 1, 1, 200, reads_state);
+      EEVM_OP(SSTORE, 2, 0, 0, reads_state | writes_state);
+      EEVM_OP(JUMP, 1, 0, 8, jump);
+      EEVM_OP(JUMPI, 2, 0, 10, jump);
+      EEVM_OP(PC, 0, 1, 2, 0);
+      EEVM_OP(MSIZE, 0, 1, 2, 0);
+      EEVM_OP(GAS, 0, 1, 2, 0);
+      EEVM_OP(JUMPDEST, 0, 0, 1, 0);
+      EEVM_OP_IMM(PUSH1, 1, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH2, 2, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH3, 3, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH4, 4, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH5, 5, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH6, 6, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH7, 7, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH8, 8, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH9, 9, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH10, 10, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH11, 11, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH12, 12, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH13, 13, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH14, 14, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH15, 15, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH16, 16, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH17, 17, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH18, 18, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH19, 19, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH20, 20, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH21, 21, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH22, 22, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH23, 23, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH24, 24, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH25, 25, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH26, 26, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH27, 27, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH28, 28, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH29, 29, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH30, 30, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH31, 31, 0, 1, 3, 0);
+      EEVM_OP_IMM(PUSH32, 32, 0, 1, 3, 0);
+      EEVM_OP(DUP1, 1, 2, 3, 0);
+      EEVM_OP(DUP2, 2, 3, 3, 0);
+      EEVM_OP(DUP3, 3, 4, 3, 0);
+      EEVM_OP(DUP4, 4, 5, 3, 0);
+      EEVM_OP(DUP5, 5, 6, 3, 0);
+      EEVM_OP(DUP6, 6, 7, 3, 0);
+      EEVM_OP(DUP7, 7, 8, 3, 0);
+      EEVM_OP(DUP8, 8, 9, 3, 0);
+      EEVM_OP(DUP9, 9, 10, 3, 0);
+      EEVM_OP(DUP10, 10, 11, 3, 0);
+      EEVM_OP(DUP11, 11, 12, 3, 0);
+      EEVM_OP(DUP12, 12, 13, 3, 0);
+      EEVM_OP(DUP13, 13, 14, 3, 0);
+      EEVM_OP(DUP14, 14, 15, 3, 0);
+      EEVM_OP(DUP15, 15, 16, 3, 0);
+      EEVM_OP(DUP16, 16, 17, 3, 0);
+      EEVM_OP(SWAP1, 2, 2, 3, 0);
+      EEVM_OP(SWAP2, 3, 3, 3, 0);
+      EEVM_OP(SWAP3, 4, 4, 3, 0);
+      EEVM_OP(SWAP4, 5, 5, 3, 0);
+      EEVM_OP(SWAP5, 6, 6, 3, 0);
+      EEVM_OP(SWAP6, 7, 7, 3, 0);
+      EEVM_OP(SWAP7, 8, 8, 3, 0);
+      EEVM_OP(SWAP8, 9, 9, 3, 0);
+      EEVM_OP(SWAP9, 10, 10, 3, 0);
+      EEVM_OP(SWAP10, 11, 11, 3, 0);
+      EEVM_OP(SWAP11, 12, 12, 3, 0);
+      EEVM_OP(SWAP12, 13, 13, 3, 0);
+      EEVM_OP(SWAP13, 14, 14, 3, 0);
+      EEVM_OP(SWAP14, 15, 15, 3, 0);
+      EEVM_OP(SWAP15, 16, 16, 3, 0);
+      EEVM_OP(SWAP16, 17, 17, 3, 0);
+      EEVM_OP(LOG0, 2, 0, 375, writes_state);
+      EEVM_OP(LOG1, 3, 0, 750, writes_state);
+      EEVM_OP(LOG2, 4, 0, 1125, writes_state);
+      EEVM_OP(LOG3, 5, 0, 1500, writes_state);
+      EEVM_OP(LOG4, 6, 0, 1875, writes_state);
+      EEVM_OP(CREATE, 3, 1, 32000, writes_state);
+      EEVM_OP(CALL, 7, 1, 700, reads_state);
+      EEVM_OP(CALLCODE, 7, 1, 700, reads_state);
+      EEVM_OP(RETURN, 2, 0, 0, terminator);
+      EEVM_OP(DELEGATECALL, 6, 1, 700, reads_state);
+      EEVM_OP(CREATE2, 4, 1, 32000, writes_state);
+      EEVM_OP(STATICCALL, 6, 1, 700, reads_state);
+      EEVM_OP(REVERT, 2, 0, 0, terminator);
+      EEVM_OP(INVALID, 0, 0, 0, terminator);
+      EEVM_OP(SELFDESTRUCT, 1, 0, 5000, terminator | writes_state);
+      return t;
+    }
+
+#undef EEVM_OP
+#undef EEVM_OP_IMM
+  } // namespace detail
+
+  /// Facts about every opcode byte, defined or not
+  inline constexpr std::array<OpInfo, 256> op_table = detail::make_op_table();
+
+  constexpr const OpInfo& op_info(uint8_t op)
+  {
+    return op_table[op];
+  }
+} // namespace eevm
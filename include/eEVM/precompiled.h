@@ -0,0 +1,43 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "nativecontract.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace eevm
+{
+  /**
+   * Native implementations of Ethereum's standard precompiled contracts.
+   * Invalid input either produces empty output (ecrecover) or throws an
+   * eevm::Exception, failing the call.
+   */
+  namespace precompiled
+  {
+    /// 0x01: recover signer address from a secp256k1 ECDSA signature
+    std::vector<uint8_t> ecrecover(ByteView input);
+    /// 0x02: SHA2-256
+    std::vector<uint8_t> sha256(ByteView input);
+    /// 0x03: RIPEMD-160, left-padded to 32 bytes
+    std::vector<uint8_t> ripemd160(ByteView input);
+    /// 0x04: returns input unchanged
+    std::vector<uint8_t> identity(ByteView input);
+    /// 0x05: arbitrary-precision modular exponentiation (EIP-198)
+    std::vector<uint8_t> modexp(ByteView input);
+    /// 0x06: point addition on alt_bn128 (EIP-196)
+    std::vector<uint8_t> bn256_add(ByteView input);
+    /// 0x07: scalar multiplication on alt_bn128 (EIP-196)
+    std::vector<uint8_t> bn256_mul(ByteView input);
+    /// 0x08: optimal ate pairing check on alt_bn128 (EIP-197)
+    std::vector<uint8_t> bn256_pairing(ByteView input);
+    /// 0x09: BLAKE2b compression function F (EIP-152)
+    std::vector<uint8_t> blake2f(ByteView input);
+
+    /// Gas cost of modexp, following EIP-198 as priced from Byzantium to
+    /// Constantinople
+    uint64_t modexp_gas(ByteView input);
+  } // namespace precompiled
+} // namespace eevm
@@ -4,11 +4,16 @@
 #pragma once
 
 #include "account.h"
+#include "fork.h"
 #include "globalstate.h"
+#include "nativecontract.h"
+#include "sha3cache.h"
 #include "trace.h"
 #include "transaction.h"
 
 #include <cstdint>
+#include <limits>
+#include <memory>
 #include <vector>
 
 namespace eevm
@@ -17,17 +22,34 @@ namespace eevm
   {
     returned = 0,
     halted,
-    threw
+    threw,
+    /// REVERT was executed. Note that state changes made during the call are
+    /// not rolled back; callers must discard them if required
+    reverted
   };
 
   struct ExecResult
   {
     ExitReason er = {};
     Exception::Type ex = {};
-    std::string exmsg = {};
+    /// pc and opcode at which execution threw. Faults in nested calls fail
+    /// those calls rather than the execution, so these are always in the
+    /// outermost frame.
+    uint64_t expc = 0;
+    Opcode exop = {};
+    /// message of the exception, held unformatted
+    ErrorMessage error = {};
     std::vector<uint8_t> output = {};
+
+    /// Formats the message of the exception, only when it is needed
+    std::string exmsg() const
+    {
+      return error.str();
+    }
   };
 
+  class ProgramCache;
+
   /**
    * Ethereum bytecode processor.
    */
@@ -35,9 +57,77 @@ namespace eevm
   {
   private:
     GlobalState& gs;
+    Sha3Cache* const sha3_cache;
+    NativeContracts natives;
+    std::unique_ptr<ProgramCache> programs;
+
+    /// Interpreter instantiated for a single fork, chosen at construction so
+    /// that no fork checks are made while executing
+    using Runner = ExecResult (*)(
+      Processor&,
+      Transaction&,
+      const Address&,
+      AccountState,
+      const std::vector<uint8_t>&,
+      const uint256_t&,
+      Trace*);
+    const Runner runner;
+
+    template <Fork F>
+    static ExecResult run_fork(
+      Processor& p,
+      Transaction& tx,
+      const Address& caller,
+      AccountState callee,
+      const std::vector<uint8_t>& input,
+      const uint256_t& call_value,
+      Trace* tr);
+    static Runner select_runner(Fork fork);
 
   public:
-    Processor(GlobalState& gs);
+    /// Default number of runs of an address's code before its analysis is
+    /// cached
+    static constexpr size_t DEFAULT_ANALYSIS_CACHE_THRESHOLD = 16;
+    /// Threshold which disables the analysis cache
+    static constexpr size_t NEVER_CACHE = std::numeric_limits<size_t>::max();
+    /// Bound on the number of programs held in the analysis cache, beyond
+    /// which the least recently used is evicted
+    static constexpr size_t MAX_CACHED_PROGRAMS = 256;
+
+    /**
+     * @param gs the global state to execute against
+     * @param sha3_cache [optional] a cache of digests for 64-byte SHA3
+     * preimages, which may outlive this Processor and be shared between them
+     * @param fork [optional] the fork whose instruction set is executed
+     */
+    Processor(
+      GlobalState& gs,
+      Sha3Cache* sha3_cache = nullptr,
+      Fork fork = Fork::latest);
+    ~Processor();
+
+    /**
+     * @brief The native contracts which calls may be routed to, in place of
+     * any code at their address. Initially holds the standard precompiles of
+     * the fork this was constructed for; entries may be added, replaced or
+     * removed to register native extensions.
+     */
+    NativeContracts& get_native_contracts();
+
+    /**
+     * @brief Sets how many times the code at an address is run before its
+     * analysis is cached. Cached programs are analysed once, with every PUSH
+     * immediate pre-decoded and selector dispatch tables built, and reused by
+     * later runs of this Processor; they are still interpreted. 0 caches code
+     * on first use.
+     */
+    void set_analysis_cache_threshold(size_t executions);
+    /// Number of programs currently held in the analysis cache
+    size_t num_cached_programs() const;
+    /// Number of programs analysed for the cache so far, including any since
+    /// evicted
+    uint64_t num_cache_fills() const;
+
     /**
      * @brief The main entry point for the EVM.
      *
@@ -0,0 +1,75 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "util.h"
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+namespace eevm
+{
+  /**
+   * Bounded LRU cache of Keccak-256 digests for 64-byte preimages.
+   *
+   * Solidity computes mapping slots as keccak256(key . slot), so contracts
+   * which repeatedly access the same mapping entries (eg, ERC20 balances)
+   * hash the same 64-byte preimages many times. A Processor given one of these
+   * will look up SHA3 results of that size here before hashing. A single cache
+   * may be shared by multiple Processors and transactions, but is not
+   * thread-safe.
+   */
+  class Sha3Cache
+  {
+  public:
+    static constexpr size_t PREIMAGE_SIZE = 64;
+    using Preimage = std::array<uint8_t, PREIMAGE_SIZE>;
+
+    struct Stats
+    {
+      uint64_t hits = 0;
+      uint64_t misses = 0;
+      uint64_t evictions = 0;
+
+      double hit_rate() const
+      {
+        const auto lookups = hits + misses;
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+      }
+    };
+
+  private:
+    struct PreimageHash
+    {
+      size_t operator()(const Preimage& p) const;
+    };
+
+    using Entry = std::pair<Preimage, KeccakHash>;
+
+    const size_t max_entries;
+    // Most recently used at the front
+    std::list<Entry> entries;
+    std::unordered_map<Preimage, std::list<Entry>::iterator, PreimageHash>
+      index;
+    Stats stats;
+
+  public:
+    explicit Sha3Cache(size_t max_entries = 4096);
+
+    /**
+     * Returns the Keccak-256 digest of the PREIMAGE_SIZE bytes at preimage,
+     * computing and inserting it if it is not already cached.
+     */
+    KeccakHash get(const uint8_t* preimage);
+
+    size_t size() const;
+    size_t capacity() const;
+    void clear();
+
+    const Stats& get_stats() const;
+    void reset_stats();
+  };
+} // namespace eevm
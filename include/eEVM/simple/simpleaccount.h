@@ -4,43 +4,46 @@
 #pragma once
 
 #include "eEVM/account.h"
+#include "eEVM/codestore.h"
 
 #include <nlohmann/json.hpp>
 
 namespace eevm
 {
   /**
-   * Simple implementation of Account
+   * The fields of a simple Account other than its address, which
+   * SimpleGlobalState keeps apart from them. Code is held in the CodeStore,
+   * so is shared with every other account holding the same code, and its
+   * hash is held inline, so that the fields a call or transfer reads
+   * (balance, nonce and code hash) are contiguous and reached without
+   * following a pointer.
    */
-  class SimpleAccount : public Account
+  class SimpleAccountBase : public Account
   {
   private:
-    Address address = {};
     uint256_t balance = {};
-    Code code = {};
     Nonce nonce = {};
+    uint256_t code_hash = empty_code_hash();
+    /// null for an account without code
+    SharedCode code = {};
 
-  public:
-    SimpleAccount() = default;
+    static SharedCode share(Code c)
+    {
+      return c.empty() ? nullptr : CodeStore::instance().intern(std::move(c));
+    }
 
-    SimpleAccount(const Address& a, const uint256_t& b, const Code& c) :
-      address(a),
-      balance(b),
-      code(c),
-      nonce(0)
-    {}
-
-    SimpleAccount(
-      const Address& a, const uint256_t& b, const Code& c, Nonce n) :
-      address(a),
+  protected:
+    SimpleAccountBase() = default;
+    SimpleAccountBase(const uint256_t& b, const Code& c, Nonce n) :
       balance(b),
-      code(c),
-      nonce(n)
-    {}
-
-    virtual Address get_address() const override;
-    void set_address(const Address& a);
+      nonce(n),
+      code(share(c))
+    {
+      if (code)
+        code_hash = code->hash;
+    }
 
+  public:
     virtual uint256_t get_balance() const override;
     virtual void set_balance(const uint256_t& b) override;
 
@@ -50,11 +53,44 @@ namespace eevm
 
     virtual Code get_code() const override;
     virtual void set_code(Code&& c) override;
+    virtual size_t get_code_size() const override;
+    virtual uint256_t get_code_hash() const override;
+    virtual bool holds_code_hash() const override;
     virtual bool has_code() override;
 
     bool operator==(const Account&) const;
 
-    friend void to_json(nlohmann::json&, const SimpleAccount&);
+    friend void from_json(const nlohmann::json&, SimpleAccountBase&);
+  };
+
+  void to_json(nlohmann::json&, const SimpleAccountBase&);
+  void from_json(const nlohmann::json&, SimpleAccountBase&);
+
+  /**
+   * Simple implementation of Account, which holds its own address
+   */
+  class SimpleAccount : public SimpleAccountBase
+  {
+  private:
+    Address address = {};
+
+  public:
+    SimpleAccount() = default;
+
+    SimpleAccount(const Address& a, const uint256_t& b, const Code& c) :
+      SimpleAccountBase(b, c, 0),
+      address(a)
+    {}
+
+    SimpleAccount(
+      const Address& a, const uint256_t& b, const Code& c, Nonce n) :
+      SimpleAccountBase(b, c, n),
+      address(a)
+    {}
+
+    virtual Address get_address() const override;
+    void set_address(const Address& a);
+
     friend void from_json(const nlohmann::json&, SimpleAccount&);
   };
 
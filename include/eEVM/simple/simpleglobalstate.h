@@ -7,10 +7,27 @@
 #include "eEVM/simple/simpleaccount.h"
 #include "eEVM/simple/simplestorage.h"
 
+#include <deque>
+#include <map>
+#include <vector>
+
 namespace eevm
 {
   /**
-   * Simple std::map-backed implementation of GlobalState
+   * Simple implementation of GlobalState
+   *
+   * Each account is given a handle, under which its account record lives in
+   * one dense slab and its storage in another, so that calls and transfers
+   * do not pull storage maps in beside the records. A record holds balance,
+   * nonce and code hash inline, and refers to its address rather than
+   * holding it: the address is the key of the account's node in the
+   * std::map from address to handle, which also keeps iteration in address
+   * order.
+   *
+   * Slabs are deques and map nodes are stable, so records and their
+   * addresses do not move as accounts are added, and an AccountState stays
+   * valid until its account is removed. The handles of removed accounts are
+   * reused.
    */
   class SimpleGlobalState : public GlobalState
   {
@@ -18,9 +35,45 @@ namespace eevm
     using StateEntry = std::pair<SimpleAccount, SimpleStorage>;
 
   private:
+    using Handle = size_t;
+    using Handles = std::map<Address, Handle>;
+
+    /// An account record, whose address is the key of its node in handles
+    class Record : public SimpleAccountBase
+    {
+      friend class SimpleGlobalState;
+      const Address* address = nullptr;
+
+    public:
+      Record() = default;
+      Record(SimpleAccountBase&& acc) : SimpleAccountBase(std::move(acc)) {}
+
+      Address get_address() const override
+      {
+        return *address;
+      }
+    };
+
     Block currentBlock;
 
-    std::map<Address, StateEntry> accounts;
+    Handles handles;
+    /// hot: indexed by handle
+    std::deque<Record> accounts;
+    /// cold: indexed by handle
+    std::deque<SimpleStorage> storage;
+    std::vector<Handle> free_handles;
+
+    Handle allocate(SimpleAccountBase&& acc, SimpleStorage&& st);
+    /// Adds an account at addr, whose position in handles is hinted by hint
+    Handles::iterator add(
+      Handles::const_iterator hint,
+      const Address& addr,
+      SimpleAccountBase&& acc,
+      SimpleStorage&& st);
+    AccountState at(Handle h)
+    {
+      return {accounts[h], storage[h]};
+    }
 
   public:
     SimpleGlobalState() = default;
@@ -32,7 +85,8 @@ namespace eevm
     AccountState create(
       const Address& addr, const uint256_t& balance, const Code& code) override;
 
-    bool exists(const Address& addr);
+    bool exists(const Address& addr) override;
+    const Account* find(const Address& addr) override;
     size_t num_accounts();
 
     virtual const Block& get_current_block() override;
@@ -3,31 +3,180 @@
 
 #pragma once
 #include "bigint.h"
+#include "exception.h"
 
-#include <deque>
+#include <cassert>
 #include <fmt/format_header_only.h>
 #include <fmt/ostream.h>
+#include <new>
 #include <ostream>
+#include <utility>
 
 namespace eevm
 {
   /**
    * Stack used by Processor
+   *
+   * The items live in a single buffer of MAX_SIZE words, allocated up front,
+   * with sp pointing one past the top. The buffer never moves, so the hot
+   * operations are defined here, and compile to a bounds check and a
+   * pointer move, while the faults they raise are kept out of line.
+   *
+   * Each operation also has an unchecked variant, for Processor, which
+   * checks bounds once on entering each basic block, against the block's
+   * requirements found by analysing the code, and before each instruction
+   * of a block which does not meet them. These only assert their bounds.
+   * Processor pops 64-bit operands with pop_unchecked and fits64, so that it
+   * can raise too_large rather than throw it.
    */
   class Stack
   {
   private:
-    std::deque<uint256_t> st;
+    uint256_t* base;
+    uint256_t* sp;
+
+    [[noreturn]] void underflow() const;
+    [[noreturn]] void overflow() const;
+    [[noreturn]] void swap_out_of_range(uint64_t i) const;
+    [[noreturn]] void dup_out_of_range(uint64_t a) const;
 
   public:
     static constexpr std::size_t MAX_SIZE = 1024;
-    Stack() = default;
-    uint256_t pop();
-    uint64_t pop64();
-    void push(const uint256_t& val);
-    uint64_t size() const;
-    void swap(uint64_t i);
-    void dup(uint64_t a);
+
+    /// Whether a value fits in 64 bits. Tests the high limbs directly,
+    /// rather than with a 256-bit comparison.
+    static bool fits64(const uint256_t& val)
+    {
+      return !(val.lo.hi | val.hi.lo | val.hi.hi);
+    }
+
+    /// The fault for an operand which does not fit in 64 bits, carrying its
+    /// value
+    static Exception too_large(const uint256_t& val);
+
+    Stack();
+    Stack(const Stack& other);
+    Stack& operator=(const Stack& other);
+    ~Stack();
+
+    uint256_t pop()
+    {
+      if (sp == base)
+        underflow();
+      return pop_unchecked();
+    }
+
+    uint64_t pop64()
+    {
+      const auto val = pop();
+      if (!fits64(val))
+        throw too_large(val);
+      return val.lo.lo;
+    }
+
+    void push(const uint256_t& val)
+    {
+      if (sp == base + MAX_SIZE)
+        overflow();
+      push_unchecked(val);
+    }
+
+    uint64_t size() const
+    {
+      return sp - base;
+    }
+
+    const uint256_t& top() const
+    {
+      if (sp == base)
+        underflow();
+      return top_unchecked();
+    }
+
+    void swap(uint64_t i)
+    {
+      if (i >= size())
+        swap_out_of_range(i);
+      swap_unchecked(i);
+    }
+
+    void dup(uint64_t a)
+    {
+      if (a >= size())
+        dup_out_of_range(a);
+      push(sp[-1 - static_cast<std::ptrdiff_t>(a)]);
+    }
+
+    /// SWAPn and DUPn, with their depths known at compile time
+    template <uint64_t I>
+    void swap()
+    {
+      swap(I);
+    }
+
+    template <uint64_t A>
+    void dup()
+    {
+      dup(A);
+    }
+
+    /// The live items, from the bottom of the stack to its top
+    const uint256_t* begin() const
+    {
+      return base;
+    }
+
+    const uint256_t* end() const
+    {
+      return sp;
+    }
+
+    //
+    // unchecked variants, for Processor
+    //
+    uint256_t pop_unchecked()
+    {
+      assert(sp != base);
+      return *--sp;
+    }
+
+    void push_unchecked(const uint256_t& val)
+    {
+      assert(sp != base + MAX_SIZE);
+      new (sp++) uint256_t(val);
+    }
+
+    const uint256_t& top_unchecked() const
+    {
+      assert(sp != base);
+      return sp[-1];
+    }
+
+    void swap_unchecked(uint64_t i)
+    {
+      assert(i < size());
+      std::swap(sp[-1], sp[-1 - static_cast<std::ptrdiff_t>(i)]);
+    }
+
+    void dup_unchecked(uint64_t a)
+    {
+      assert(a < size());
+      push_unchecked(sp[-1 - static_cast<std::ptrdiff_t>(a)]);
+    }
+
+    template <uint64_t I>
+    void swap_unchecked()
+    {
+      assert(I < size());
+      std::swap(sp[-1], sp[-1 - static_cast<std::ptrdiff_t>(I)]);
+    }
+
+    template <uint64_t A>
+    void dup_unchecked()
+    {
+      assert(A < size());
+      push_unchecked(sp[-1 - static_cast<std::ptrdiff_t>(A)]);
+    }
 
     friend std::ostream& operator<<(std::ostream& os, const Stack& s);
   };
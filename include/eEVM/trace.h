@@ -2,9 +2,10 @@
 // Licensed under the MIT License.
 
 #pragma once
-#include "disassembler.h"
 #include "opcode.h"
+#include "opcodeinfo.h"
 #include "stack.h"
+#include "util.h"
 
 #include <fmt/format_header_only.h>
 #include <iostream>
@@ -19,24 +20,26 @@ namespace eevm
     const uint64_t pc;
     const Opcode op;
     const uint16_t call_depth;
-    std::unique_ptr<Stack> s;
+    /// live items of the stack, bottom first. Only these are copied, rather
+    /// than the whole of the stack's buffer.
+    std::vector<uint256_t> stack;
 
     TraceEvent(
       const uint64_t pc,
       const Opcode op,
       const uint16_t call_depth,
-      const Stack s) :
+      const Stack& s) :
       pc(pc),
       op(op),
       call_depth(call_depth),
-      s(std::make_unique<Stack>(s))
+      stack(s.begin(), s.end())
     {}
 
     TraceEvent(TraceEvent&& other) :
       pc(other.pc),
       op(other.op),
       call_depth(other.call_depth),
-      s(std::move(other.s))
+      stack(std::move(other.stack))
     {}
   };
 
@@ -90,10 +93,16 @@ namespace fmt
         "{} ({}): {}",
         e.pc,
         e.call_depth,
-        eevm::Disassembler::getOp(e.op).mnemonic);
+        eevm::op_info(e.op).mnemonic);
 
-      if (e.s)
-        s = format_to(ctx.out(), "\nstack before:\n{}", *e.s);
+      // As Stack prints itself, from the top
+      s = format_to(ctx.out(), "\nstack before:\n");
+      for (size_t i = 0; i < e.stack.size(); ++i)
+        s = format_to(
+          ctx.out(),
+          " {}: {}\n",
+          i,
+          eevm::to_hex_string(e.stack[e.stack.size() - 1 - i]));
 
       return s;
     }
@@ -97,6 +97,33 @@ namespace eevm
     return keccak_256((const uint8_t*)t.data() + skip, t.size() - skip);
   }
 
+  struct KeccakInput
+  {
+    const uint8_t* data;
+    size_t size;
+  };
+
+  /**
+   * Computes the Keccak-256 digests of n independent inputs, writing the i-th
+   * digest to outputs[i]. Where the host supports it, inputs are hashed 8 or 4
+   * at a time in parallel SIMD lanes (AVX-512/AVX2), otherwise one at a time.
+   */
+  void keccak_256_batch(
+    const KeccakInput* inputs, size_t n, KeccakHash* outputs);
+
+  template <typename T>
+  inline std::vector<KeccakHash> keccak_256_batch(const std::vector<T>& ts)
+  {
+    std::vector<KeccakInput> inputs;
+    inputs.reserve(ts.size());
+    for (const auto& t : ts)
+      inputs.push_back({(const uint8_t*)t.data(), t.size()});
+
+    std::vector<KeccakHash> outputs(ts.size());
+    keccak_256_batch(inputs.data(), inputs.size(), outputs.data());
+    return outputs;
+  }
+
   std::string strip(const std::string& s);
   std::vector<uint8_t> to_bytes(const std::string& s);
 
@@ -151,13 +178,10 @@ namespace eevm
     return intx::from_string<uint256_t>(s);
   }
 
-  inline std::string to_checksum_address(const Address& a)
+  // Applies EIP-55 mixed-case checksum to s, where h is the hash of the
+  // lowercase hex digits of s
+  inline void apply_checksum(std::string& s, const KeccakHash& h)
   {
-    auto s = address_to_hex_string(a);
-
-    // Start at index 2 to skip the "0x" prefix
-    const auto h = keccak_256_skip(2, s);
-
     for (size_t i = 0; i < s.size() - 2; ++i)
     {
       auto& c = s[i + 2];
@@ -173,10 +197,21 @@ namespace eevm
         }
       }
     }
+  }
+
+  inline std::string to_checksum_address(const Address& a)
+  {
+    auto s = address_to_hex_string(a);
+
+    // Start at index 2 to skip the "0x" prefix
+    apply_checksum(s, keccak_256_skip(2, s));
 
     return s;
   }
 
+  std::vector<std::string> to_checksum_addresses(
+    const std::vector<Address>& addresses);
+
   inline bool is_checksum_address(const std::string& s)
   {
     const auto cs = to_checksum_address(to_uint256(s));
@@ -185,5 +220,11 @@ namespace eevm
 
   Address generate_address(const Address& sender, uint64_t nonce);
 
+  /// Address of a contract created by CREATE2 (EIP-1014)
+  Address generate_address(
+    const Address& sender,
+    const uint256_t& salt,
+    const std::vector<uint8_t>& init_code);
+
   uint64_t to_uint64(const std::string& s);
 } // namespace eevm
@@ -75,7 +75,7 @@ std::vector<uint8_t> run_and_check_result(
     {
       // Rethrow to highlight any exceptions raised in execution
       throw std::runtime_error(
-        fmt::format("Execution threw an error: {}", exec_result.exmsg));
+        fmt::format("Execution threw an error: {}", exec_result.exmsg()));
     }
 
     throw std::runtime_error("Deployment did not return");
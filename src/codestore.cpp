@@ -0,0 +1,65 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "eEVM/codestore.h"
+
+#include "eEVM/util.h"
+
+namespace eevm
+{
+  namespace
+  {
+    uint256_t hash_code(const Code& code)
+    {
+      return from_big_endian(keccak_256(code).data());
+    }
+  } // namespace
+
+  CodeStore& CodeStore::instance()
+  {
+    static auto store = new CodeStore();
+    return *store;
+  }
+
+  SharedCode CodeStore::intern(Code&& code)
+  {
+    // Hashed before locking, so that other threads are not held up by it
+    auto hash = hash_code(code);
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto& entry = entries[hash];
+    if (auto held = entry.lock())
+      return held;
+
+    SharedCode stored(
+      new StoredCode{std::move(code), std::move(hash)},
+      [this](const StoredCode* c) { release(c); });
+    entry = stored;
+    return stored;
+  }
+
+  void CodeStore::release(const StoredCode* code)
+  {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      // The entry may already hold a newer copy, interned after the last
+      // reference to this one was dropped
+      const auto it = entries.find(code->hash);
+      if (it != entries.end() && it->second.expired())
+        entries.erase(it);
+    }
+    delete code;
+  }
+
+  size_t CodeStore::size()
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    return entries.size();
+  }
+
+  const uint256_t& empty_code_hash()
+  {
+    static const auto hash = hash_code({});
+    return hash;
+  }
+} // namespace eevm
@@ -0,0 +1,20 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// Compiled with -mavx2; see lanes.h for the restrictions this imposes.
+#include "lanes.h"
+#include "simd.h"
+
+namespace eevm
+{
+  namespace keccak_simd
+  {
+    typedef uint64_t V4 __attribute__((vector_size(32)));
+
+    void keccak_256_x4_avx2(
+      const uint8_t* const* data, const size_t* sizes, uint8_t* const* out)
+    {
+      keccak_lanes::keccak_256_lanes<V4, 4>(data, sizes, out);
+    }
+  } // namespace keccak_simd
+} // namespace eevm
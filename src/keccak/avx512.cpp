@@ -0,0 +1,20 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// Compiled with -mavx512f; see lanes.h for the restrictions this imposes.
+#include "lanes.h"
+#include "simd.h"
+
+namespace eevm
+{
+  namespace keccak_simd
+  {
+    typedef uint64_t V8 __attribute__((vector_size(64)));
+
+    void keccak_256_x8_avx512(
+      const uint8_t* const* data, const size_t* sizes, uint8_t* const* out)
+    {
+      keccak_lanes::keccak_256_lanes<V8, 8>(data, sizes, out);
+    }
+  } // namespace keccak_simd
+} // namespace eevm
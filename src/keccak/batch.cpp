@@ -0,0 +1,108 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "eEVM/util.h"
+
+#include "simd.h"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace std;
+
+namespace eevm
+{
+#ifdef EEVM_KECCAK_SIMD
+  namespace
+  {
+    constexpr size_t MAX_LANES = 8;
+
+    struct LaneSupport
+    {
+      const bool avx2;
+      const bool avx512;
+
+      LaneSupport() :
+        avx2(__builtin_cpu_supports("avx2")),
+        avx512(__builtin_cpu_supports("avx512f"))
+      {}
+    };
+
+    const LaneSupport& lane_support()
+    {
+      static const LaneSupport ls;
+      return ls;
+    }
+
+    template <typename F>
+    void hash_group(
+      F&& f,
+      const size_t width,
+      const KeccakInput* inputs,
+      const size_t* order,
+      KeccakHash* outputs)
+    {
+      const uint8_t* data[MAX_LANES];
+      size_t sizes[MAX_LANES];
+      uint8_t* out[MAX_LANES];
+      for (size_t k = 0; k < width; ++k)
+      {
+        const auto idx = order[k];
+        data[k] = inputs[idx].data;
+        sizes[k] = inputs[idx].size;
+        out[k] = outputs[idx].data();
+      }
+      f(data, sizes, out);
+    }
+  } // namespace
+#endif
+
+  void keccak_256_batch(
+    const KeccakInput* inputs, size_t n, KeccakHash* outputs)
+  {
+    size_t done = 0;
+    vector<size_t> order(n);
+    iota(order.begin(), order.end(), 0);
+
+#ifdef EEVM_KECCAK_SIMD
+    const auto& ls = lane_support();
+    if (ls.avx2 && n >= 4)
+    {
+      // Every lane in a group is permuted as many times as its longest input
+      // needs, so group inputs of similar length together
+      constexpr size_t rate = 136;
+      stable_sort(order.begin(), order.end(), [inputs](size_t a, size_t b) {
+        return inputs[a].size / rate < inputs[b].size / rate;
+      });
+
+      if (ls.avx512)
+      {
+        for (; done + 8 <= n; done += 8)
+          hash_group(
+            keccak_simd::keccak_256_x8_avx512,
+            8,
+            inputs,
+            order.data() + done,
+            outputs);
+      }
+
+      for (; done + 4 <= n; done += 4)
+        hash_group(
+          keccak_simd::keccak_256_x4_avx2,
+          4,
+          inputs,
+          order.data() + done,
+          outputs);
+    }
+#endif
+
+    for (; done < n; ++done)
+    {
+      const auto& in = inputs[order[done]];
+      keccak_256(
+        in.data,
+        static_cast<unsigned int>(in.size),
+        outputs[order[done]].data());
+    }
+  }
+} // namespace eevm
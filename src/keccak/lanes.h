@@ -0,0 +1,187 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Lane-parallel Keccak-256. This header is included by translation units which
+// are compiled with different target flags (AVX2, AVX-512), so it must not pull
+// in any inline library code, and everything here has internal linkage -
+// otherwise the linker may keep a copy using instructions the host does not
+// support. It is only built for x86-64, so lanes are loaded and stored in host
+// (little-endian) byte order.
+namespace eevm
+{
+  namespace
+  {
+    namespace keccak_lanes
+    {
+      constexpr size_t RATE = 136;
+      constexpr size_t RATE_WORDS = RATE / 8;
+
+      constexpr uint64_t round_constants[24] = {
+        0x0000000000000001ull, 0x0000000000008082ull, 0x800000000000808aull,
+        0x8000000080008000ull, 0x000000000000808bull, 0x0000000080000001ull,
+        0x8000000080008081ull, 0x8000000000008009ull, 0x000000000000008aull,
+        0x0000000000000088ull, 0x0000000080008009ull, 0x000000008000000aull,
+        0x000000008000808bull, 0x800000000000008bull, 0x8000000000008089ull,
+        0x8000000000008003ull, 0x8000000000008002ull, 0x8000000000000080ull,
+        0x000000000000800aull, 0x800000008000000aull, 0x8000000080008081ull,
+        0x8000000000008080ull, 0x0000000080000001ull, 0x8000000080008008ull};
+
+      constexpr int rotations[24] = {1,  3,  6,  10, 15, 21, 28, 36,
+                                     45, 55, 2,  14, 27, 41, 56, 8,
+                                     25, 43, 62, 18, 39, 61, 20, 44};
+
+      constexpr int pi_lanes[24] = {10, 7,  11, 17, 18, 3, 5,  16,
+                                    8,  21, 24, 4,  15, 23, 19, 13,
+                                    12, 2,  20, 14, 22, 9,  6,  1};
+
+      template <typename V>
+      inline V rol(const V& v, int n)
+      {
+        return (v << n) | (v >> (64 - n));
+      }
+
+      /// Keccak-f[1600] applied to W independent states at once, where each
+      /// element of a V holds the same lane of a different state. The inner
+      /// loops are unrolled so that rotation amounts become immediates.
+      template <typename V>
+      inline void permute(V (&st)[25])
+      {
+        V bc[5];
+        for (size_t round = 0; round < 24; ++round)
+        {
+          // theta
+#pragma GCC unroll 5
+          for (size_t i = 0; i < 5; ++i)
+            bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
+
+#pragma GCC unroll 5
+          for (size_t i = 0; i < 5; ++i)
+          {
+            const V t = bc[(i + 4) % 5] ^ rol(bc[(i + 1) % 5], 1);
+#pragma GCC unroll 5
+            for (size_t j = 0; j < 25; j += 5)
+              st[j + i] ^= t;
+          }
+
+          // rho and pi
+          V t = st[1];
+#pragma GCC unroll 24
+          for (size_t i = 0; i < 24; ++i)
+          {
+            const auto j = pi_lanes[i];
+            const V tmp = st[j];
+            st[j] = rol(t, rotations[i]);
+            t = tmp;
+          }
+
+          // chi
+#pragma GCC unroll 5
+          for (size_t j = 0; j < 25; j += 5)
+          {
+#pragma GCC unroll 5
+            for (size_t i = 0; i < 5; ++i)
+              bc[i] = st[j + i];
+#pragma GCC unroll 5
+            for (size_t i = 0; i < 5; ++i)
+              st[j + i] ^= ~bc[(i + 1) % 5] & bc[(i + 2) % 5];
+          }
+
+          // iota
+          st[0] ^= round_constants[round];
+        }
+      }
+
+      inline size_t num_blocks(size_t byte_len)
+      {
+        // The final block always has room for at least one byte of padding
+        return byte_len / RATE + 1;
+      }
+
+      /// Writes block b of the padded input into out. Blocks past the end of
+      /// the input are all zero, so finished lanes absorb nothing.
+      inline void load_block(
+        const uint8_t* data, size_t size, size_t b, uint8_t (&out)[RATE])
+      {
+        const auto last = num_blocks(size) - 1;
+        if (b < last)
+        {
+          std::memcpy(out, data + b * RATE, RATE);
+          return;
+        }
+
+        std::memset(out, 0, RATE);
+        if (b == last)
+        {
+          const auto rem = size - b * RATE;
+          if (rem > 0)
+            std::memcpy(out, data + b * RATE, rem);
+          // Ethereum's Keccak-256 uses the original 0x01 domain padding
+          out[rem] ^= 0x01;
+          out[RATE - 1] ^= 0x80;
+        }
+      }
+
+      /// Hashes exactly W inputs, writing each 32-byte digest to outputs[i].
+      /// Inputs should have similar lengths, as the permutation runs for as
+      /// many blocks as the longest input needs.
+      template <typename V, size_t W>
+      inline void keccak_256_lanes(
+        const uint8_t* const* data, const size_t* sizes, uint8_t* const* outputs)
+      {
+        static_assert(sizeof(V) == W * sizeof(uint64_t), "Lane width mismatch");
+
+        size_t blocks[W];
+        size_t max_blocks = 0;
+        for (size_t i = 0; i < W; ++i)
+        {
+          blocks[i] = num_blocks(sizes[i]);
+          if (blocks[i] > max_blocks)
+            max_blocks = blocks[i];
+        }
+
+        V st[25] = {};
+        uint8_t block[RATE];
+        uint64_t words[RATE_WORDS][W];
+
+        for (size_t b = 0; b < max_blocks; ++b)
+        {
+          // Transpose the b-th block of each input into lane-major order
+          for (size_t i = 0; i < W; ++i)
+          {
+            load_block(data[i], sizes[i], b, block);
+            for (size_t w = 0; w < RATE_WORDS; ++w)
+              std::memcpy(&words[w][i], block + w * 8, sizeof(uint64_t));
+          }
+
+          for (size_t w = 0; w < RATE_WORDS; ++w)
+          {
+            V v;
+            std::memcpy(&v, words[w], sizeof(v));
+            st[w] ^= v;
+          }
+
+          permute(st);
+
+          // Squeeze lanes whose final block was just absorbed
+          for (size_t i = 0; i < W; ++i)
+          {
+            if (blocks[i] != b + 1)
+              continue;
+
+            for (size_t w = 0; w < 4; ++w)
+            {
+              const uint64_t lane = st[w][i];
+              std::memcpy(outputs[i] + w * 8, &lane, sizeof(lane));
+            }
+          }
+        }
+      }
+    } // namespace keccak_lanes
+  } // namespace
+} // namespace eevm
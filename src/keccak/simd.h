@@ -0,0 +1,20 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace eevm
+{
+  namespace keccak_simd
+  {
+    // Each of these hashes exactly 4 (or 8) inputs at once. They may only be
+    // called when the host supports the corresponding instruction set.
+    void keccak_256_x4_avx2(
+      const uint8_t* const* data, const size_t* sizes, uint8_t* const* out);
+    void keccak_256_x8_avx512(
+      const uint8_t* const* data, const size_t* sizes, uint8_t* const* out);
+  } // namespace keccak_simd
+} // namespace eevm
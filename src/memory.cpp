@@ -0,0 +1,127 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "eEVM/memory.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <sys/mman.h>
+#  define EEVM_MEMORY_MMAP
+#endif
+
+using namespace std;
+
+namespace eevm
+{
+  namespace
+  {
+    constexpr uint64_t MAP_PAGE_SIZE = 4096;
+  } // namespace
+
+  Memory::Memory(Memory&& other) noexcept :
+    buf(exchange(other.buf, nullptr)),
+    used(exchange(other.used, 0)),
+    capacity(exchange(other.capacity, 0)),
+    mapped(exchange(other.mapped, false)),
+    gas(exchange(other.gas, 0))
+  {}
+
+  Memory& Memory::operator=(Memory&& other) noexcept
+  {
+    if (this != &other)
+    {
+      release();
+      buf = exchange(other.buf, nullptr);
+      used = exchange(other.used, 0);
+      capacity = exchange(other.capacity, 0);
+      mapped = exchange(other.mapped, false);
+      gas = exchange(other.gas, 0);
+    }
+    return *this;
+  }
+
+  Memory::~Memory()
+  {
+    release();
+  }
+
+  void Memory::release()
+  {
+    if (!buf)
+      return;
+
+#ifdef EEVM_MEMORY_MMAP
+    if (mapped)
+      munmap(buf, capacity);
+    else
+#endif
+      free(buf);
+  }
+
+  void Memory::grow(uint64_t end)
+  {
+    const auto new_used = (end + WORD_SIZE - 1) / WORD_SIZE * WORD_SIZE;
+    if (new_used > capacity)
+      reserve(max({new_used, 2 * capacity, MIN_CAPACITY}));
+
+    // Mapped pages are zero until written, and bytes beyond used never have
+    // been. Heap allocations come uninitialised.
+    if (!mapped)
+      memset(buf + used, 0, new_used - used);
+
+    used = new_used;
+    const auto w = words();
+    gas = 3 * w + w * w / 512;
+  }
+
+  void Memory::reserve(uint64_t n)
+  {
+#ifdef EEVM_MEMORY_MMAP
+    if (n >= MAP_THRESHOLD)
+    {
+      n = (n + MAP_PAGE_SIZE - 1) / MAP_PAGE_SIZE * MAP_PAGE_SIZE;
+      void* p;
+#  ifdef __linux__
+      if (mapped)
+      {
+        // Remapping moves the pages rather than copying them
+        p = mremap(buf, capacity, n, MREMAP_MAYMOVE);
+        if (p == MAP_FAILED)
+          throw bad_alloc();
+      }
+      else
+#  endif
+      {
+        p = mmap(
+          nullptr,
+          n,
+          PROT_READ | PROT_WRITE,
+          MAP_PRIVATE | MAP_ANONYMOUS,
+          -1,
+          0);
+        if (p == MAP_FAILED)
+          throw bad_alloc();
+        if (used)
+          memcpy(p, buf, used);
+        release();
+      }
+
+      buf = static_cast<uint8_t*>(p);
+      capacity = n;
+      mapped = true;
+      return;
+    }
+#endif
+
+    const auto p = realloc(buf, n);
+    if (!p)
+      throw bad_alloc();
+    buf = static_cast<uint8_t*>(p);
+    capacity = n;
+  }
+} // namespace eevm
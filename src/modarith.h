@@ -0,0 +1,209 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "eEVM/bigint.h"
+
+#include <optional>
+
+namespace eevm
+{
+  /**
+   * Kernels for the EVM's modular arithmetic opcodes (ADDMOD, MULMOD, EXP)
+   */
+  namespace modarith
+  {
+    inline bool is_pow2(const uint256_t& v)
+    {
+      return v != 0 && (v & (v - 1)) == 0;
+    }
+
+    /// (x + y) mod m, for non-zero m, without widening to 512 bits
+    inline uint256_t addmod(
+      const uint256_t& x, const uint256_t& y, const uint256_t& m)
+    {
+      const auto a = x < m ? x : x % m;
+      const auto b = y < m ? y : y % m;
+
+      // a + b < 2m, so a single subtraction (wrapping, if the sum carried out
+      // of 256 bits) completes the reduction
+      const auto s = intx::add_with_carry(a, b);
+      return (s.carry || s.value >= m) ? s.value - m : s.value;
+    }
+
+    /**
+     * Reduces 512-bit products modulo a fixed, non-zero 256-bit m, by long
+     * division. The divisor is normalised and the reciprocal of its top limb
+     * computed once, so repeated reductions by the same modulus only pay for
+     * the division itself.
+     */
+    class Reducer
+    {
+      uint256_t m;
+      /// left shift normalising m, so that its top limb has the high bit set
+      unsigned shift;
+      /// normalised m, as little-endian limbs
+      uint64_t d[4];
+      /// number of significant limbs in d
+      unsigned n;
+      /// reciprocal of d[n - 1], for intx::udivrem_2by1
+      uint64_t v;
+
+    public:
+      explicit Reducer(const uint256_t& m_) : m(m_)
+      {
+        const auto bits = 256 - intx::clz(m);
+        n = (bits + 63) / 64;
+        shift = 64 * n - bits;
+
+        const auto dn = m << shift;
+        const auto dw = intx::as_words(dn);
+        for (unsigned i = 0; i < 4; ++i)
+          d[i] = dw[i];
+        v = intx::reciprocal_2by1(d[n - 1]);
+      }
+
+      const uint256_t& modulus() const
+      {
+        return m;
+      }
+
+      uint256_t reduce(const uint512_t& p) const
+      {
+        // Normalise the numerator into 9 limbs
+        const auto pw = intx::as_words(p);
+        uint64_t u[9];
+        u[8] = shift ? pw[7] >> (64 - shift) : 0;
+        for (unsigned i = 7; i > 0; --i)
+        {
+          u[i] =
+            shift ? (pw[i] << shift) | (pw[i - 1] >> (64 - shift)) : pw[i];
+        }
+        u[0] = pw[0] << shift;
+
+        for (auto j = 9 - n; j-- > 0;)
+        {
+          // Estimate the quotient limb from the top limbs. It may be at most
+          // two too large, which the correction with the next limb of the
+          // divisor (or otherwise, the final add-back) fixes.
+          uint64_t qhat;
+          uint64_t rhat;
+          bool rhat_overflow = false;
+          if (u[j + n] >= d[n - 1])
+          {
+            qhat = ~uint64_t(0);
+            const auto r = intx::uint128(u[j + n - 1]) + d[n - 1];
+            rhat = r.lo;
+            rhat_overflow = r.hi != 0;
+          }
+          else
+          {
+            const auto r =
+              intx::udivrem_2by1({u[j + n], u[j + n - 1]}, d[n - 1], v);
+            qhat = r.quot;
+            rhat = r.rem;
+          }
+
+          while (n > 1 && !rhat_overflow &&
+                 intx::umul(qhat, d[n - 2]) >
+                   intx::uint128{rhat, u[j + n - 2]})
+          {
+            --qhat;
+            const auto r = intx::uint128(rhat) + d[n - 1];
+            rhat = r.lo;
+            rhat_overflow = r.hi != 0;
+          }
+
+          // u[j..j+n] -= qhat * d
+          uint64_t borrow = 0, carry = 0;
+          for (unsigned i = 0; i < n; ++i)
+          {
+            const auto prod = intx::umul(qhat, d[i]) + carry;
+            carry = prod.hi;
+            const auto t = u[i + j] - prod.lo;
+            const auto b = u[i + j] < prod.lo;
+            u[i + j] = t - borrow;
+            borrow = b | (t < borrow);
+          }
+          const auto t = u[j + n] - carry;
+          const auto b = u[j + n] < carry;
+          u[j + n] = t - borrow;
+          borrow = b | (t < borrow);
+
+          // qhat was one too large: add the divisor back
+          if (borrow)
+          {
+            uint64_t c = 0;
+            for (unsigned i = 0; i < n; ++i)
+            {
+              const auto sum = intx::uint128(u[i + j]) + d[i] + c;
+              u[i + j] = sum.lo;
+              c = sum.hi;
+            }
+            u[j + n] += c;
+          }
+        }
+
+        // Denormalise the remainder, held in the low n limbs
+        uint256_t r;
+        const auto rw = intx::as_words(r);
+        for (unsigned i = 0; i < n; ++i)
+          rw[i] = shift ? (u[i] >> shift) | (u[i + 1] << (64 - shift)) : u[i];
+        return r;
+      }
+    };
+
+    /// (x * y) mod m, for non-zero m. reducer caches the Reducer for the
+    /// most recent modulus, and is replaced if m differs.
+    inline uint256_t mulmod(
+      const uint256_t& x,
+      const uint256_t& y,
+      const uint256_t& m,
+      std::optional<Reducer>& reducer)
+    {
+      // Powers of two only need the low bits of the product
+      if (is_pow2(m))
+        return (x * y) & (m - 1);
+
+      // Products which fit in 256 bits need only a 256-bit division
+      if (x.hi == 0 && y.hi == 0)
+        return intx::umul(x.lo, y.lo) % m;
+
+      if (!reducer || reducer->modulus() != m)
+        reducer.emplace(m);
+      return reducer->reduce(intx::umul(x, y));
+    }
+
+    /// base^exponent mod 2^256, by left-to-right square-and-multiply over
+    /// the full 256-bit exponent
+    inline uint256_t exp(const uint256_t& base, const uint256_t& exponent)
+    {
+      if (exponent == 0)
+        return 1;
+      if (base < 2)
+        return base;
+
+      // (2^k)^e = 2^(k * e), which is 0 once k * e reaches 256
+      if (is_pow2(base))
+      {
+        if (exponent >= 256)
+          return 0;
+        const auto k = 255 - intx::clz(base);
+        const auto shift = k * static_cast<unsigned>(exponent);
+        return shift >= 256 ? uint256_t(0) : uint256_t(1) << shift;
+      }
+
+      const auto ew = intx::as_words(exponent);
+      auto result = base;
+      const auto top = 255 - static_cast<int>(intx::clz(exponent));
+      for (auto bit = top - 1; bit >= 0; --bit)
+      {
+        result *= result;
+        if ((ew[bit / 64] >> (bit % 64)) & 1)
+          result *= base;
+      }
+      return result;
+    }
+  } // namespace modarith
+} // namespace eevm
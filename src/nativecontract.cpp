@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "eEVM/nativecontract.h"
+
+using namespace std;
+
+namespace eevm
+{
+  namespace
+  {
+    class FunctionContract : public NativeContract
+    {
+      const NativeFunction fn;
+      const NativeGasFunction gas_fn;
+
+    public:
+      FunctionContract(NativeFunction fn, NativeGasFunction gas_fn) :
+        fn(move(fn)),
+        gas_fn(move(gas_fn))
+      {}
+
+      uint64_t gas(ByteView input) const override
+      {
+        return gas_fn ? gas_fn(input) : 0;
+      }
+
+      void execute(ByteView input, NativeOutput& output) override
+      {
+        output.write(fn(input));
+      }
+    };
+  } // namespace
+
+  void NativeOutput::write(ByteView bytes)
+  {
+    buf.insert(buf.end(), bytes.begin(), bytes.end());
+  }
+
+  void NativeContracts::add(
+    const Address& addr, shared_ptr<NativeContract> contract)
+  {
+    contracts[addr] = move(contract);
+  }
+
+  void NativeContracts::add(
+    const Address& addr, NativeFunction execute, NativeGasFunction gas)
+  {
+    add(addr, make_shared<FunctionContract>(move(execute), move(gas)));
+  }
+
+  bool NativeContracts::remove(const Address& addr)
+  {
+    return contracts.erase(addr) != 0;
+  }
+
+  NativeContract* NativeContracts::find(const Address& addr) const
+  {
+    const auto it = contracts.find(addr);
+    return it == contracts.end() ? nullptr : it->second.get();
+  }
+} // namespace eevm
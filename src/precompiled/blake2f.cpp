@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "eEVM/exception.h"
+#include "eEVM/precompiled.h"
+
+using namespace std;
+
+namespace eevm
+{
+  namespace precompiled
+  {
+    namespace
+    {
+      constexpr uint64_t IV[8] = {0x6a09e667f3bcc908ull,
+                                  0xbb67ae8584caa73bull,
+                                  0x3c6ef372fe94f82bull,
+                                  0xa54ff53a5f1d36f1ull,
+                                  0x510e527fade682d1ull,
+                                  0x9b05688c2b3e6c1full,
+                                  0x1f83d9abfb41bd6bull,
+                                  0x5be0cd19137e2179ull};
+
+      constexpr uint8_t SIGMA[10][16] = {
+        {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+        {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+        {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+        {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+        {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+        {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+        {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+        {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+        {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+        {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0}};
+
+      inline uint64_t rotr(uint64_t x, int n)
+      {
+        return (x >> n) | (x << (64 - n));
+      }
+
+      inline uint64_t load_le64(const uint8_t* p)
+      {
+        uint64_t v = 0;
+        for (size_t i = 0; i < 8; ++i)
+          v |= uint64_t(p[i]) << (8 * i);
+        return v;
+      }
+
+      inline void g(
+        uint64_t* v, int a, int b, int c, int d, uint64_t x, uint64_t y)
+      {
+        v[a] = v[a] + v[b] + x;
+        v[d] = rotr(v[d] ^ v[a], 32);
+        v[c] = v[c] + v[d];
+        v[b] = rotr(v[b] ^ v[c], 24);
+        v[a] = v[a] + v[b] + y;
+        v[d] = rotr(v[d] ^ v[a], 16);
+        v[c] = v[c] + v[d];
+        v[b] = rotr(v[b] ^ v[c], 63);
+      }
+    } // namespace
+
+    vector<uint8_t> blake2f(ByteView input)
+    {
+      // rounds (4, big-endian) | h (64) | m (128) | t (16) | f (1)
+      if (input.size() != 213)
+        throw Exception(
+          Exception::Type::outOfBounds,
+          "blake2f input must be exactly 213 bytes");
+
+      const auto final_flag = input[212];
+      if (final_flag > 1)
+        throw Exception(
+          Exception::Type::illegalInstruction,
+          "blake2f final block indicator must be 0 or 1");
+
+      const auto* p = input.data();
+      const uint32_t rounds = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) |
+        (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+
+      uint64_t h[8], m[16];
+      for (size_t i = 0; i < 8; ++i)
+        h[i] = load_le64(p + 4 + 8 * i);
+      for (size_t i = 0; i < 16; ++i)
+        m[i] = load_le64(p + 68 + 8 * i);
+
+      uint64_t v[16];
+      for (size_t i = 0; i < 8; ++i)
+      {
+        v[i] = h[i];
+        v[i + 8] = IV[i];
+      }
+      v[12] ^= load_le64(p + 196);
+      v[13] ^= load_le64(p + 204);
+      if (final_flag)
+        v[14] = ~v[14];
+
+      for (uint32_t r = 0; r < rounds; ++r)
+      {
+        const auto& s = SIGMA[r % 10];
+        g(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+        g(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+        g(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+        g(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+        g(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+        g(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+        g(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+        g(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+      }
+
+      vector<uint8_t> output(64);
+      for (size_t i = 0; i < 8; ++i)
+      {
+        const auto w = h[i] ^ v[i] ^ v[i + 8];
+        for (size_t j = 0; j < 8; ++j)
+          output[8 * i + j] = static_cast<uint8_t>(w >> (8 * j));
+      }
+      return output;
+    }
+  } // namespace precompiled
+} // namespace eevm
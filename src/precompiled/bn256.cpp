@@ -0,0 +1,536 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "curve.h"
+#include "eEVM/exception.h"
+#include "eEVM/precompiled.h"
+#include "field.h"
+#include "input.h"
+
+#include <array>
+
+using namespace std;
+
+namespace eevm
+{
+  namespace precompiled
+  {
+    namespace
+    {
+      struct Bn256Prime
+      {
+        static constexpr Limbs modulus{{0x3c208c16d87cfd47ull,
+                                        0x97816a916871ca8dull,
+                                        0xb85045b68181585dull,
+                                        0x30644e72e131a029ull}};
+      };
+
+      using Fq = Fp<Bn256Prime>;
+
+      /// Order of G1 and G2
+      const uint256_t& group_order()
+      {
+        static const auto r = intx::from_string<uint256_t>(
+          "0x30644e72e131a029b85045b68181585d2833e84879b9709143e1f593f0000001");
+        return r;
+      }
+
+      /// 6u + 2, where u is the BN parameter
+      constexpr uint64_t ATE_LOOP_COUNT_HI = 0x1;
+      constexpr uint64_t ATE_LOOP_COUNT_LO = 0x9d797039be763ba8ull;
+
+      /// (p^4 - p^2 + 1) / r, little-endian limbs
+      constexpr uint64_t FINAL_EXPONENT[12] = {0xe81bb482ccdf42b1ull,
+                                               0x5abf5cc4f49c36d4ull,
+                                               0xf1154e7e1da014fdull,
+                                               0xdcc7b44c87cdbacfull,
+                                               0xaaa441e3954bcf8aull,
+                                               0x6b887d56d5095f23ull,
+                                               0x79581e16f3fd90c6ull,
+                                               0x3b1b1355d189227dull,
+                                               0x4e529a5861876f6bull,
+                                               0x6c0eb522d5b12278ull,
+                                               0x331ec15183177fafull,
+                                               0x01baaa710b0759adull};
+
+      /// Fq[i] / (i^2 + 1)
+      struct Fq2
+      {
+        Fq a, b; // a + b i
+
+        static Fq2 zero()
+        {
+          return {};
+        }
+
+        static Fq2 one()
+        {
+          return {Fq::one(), Fq::zero()};
+        }
+
+        bool is_zero() const
+        {
+          return a.is_zero() && b.is_zero();
+        }
+
+        bool operator==(const Fq2& o) const
+        {
+          return a == o.a && b == o.b;
+        }
+
+        bool operator!=(const Fq2& o) const
+        {
+          return !(*this == o);
+        }
+
+        Fq2 operator+(const Fq2& o) const
+        {
+          return {a + o.a, b + o.b};
+        }
+
+        Fq2 operator-(const Fq2& o) const
+        {
+          return {a - o.a, b - o.b};
+        }
+
+        Fq2 operator-() const
+        {
+          return {-a, -b};
+        }
+
+        Fq2 operator*(const Fq2& o) const
+        {
+          // Karatsuba: 3 base field multiplications
+          const auto aa = a * o.a;
+          const auto bb = b * o.b;
+          return {aa - bb, (a + b) * (o.a + o.b) - aa - bb};
+        }
+
+        Fq2 operator*(const Fq& s) const
+        {
+          return {a * s, b * s};
+        }
+
+        Fq2 square() const
+        {
+          return {(a + b) * (a - b), (a * b).dbl()};
+        }
+
+        Fq2 dbl() const
+        {
+          return {a.dbl(), b.dbl()};
+        }
+
+        Fq2 conj() const
+        {
+          return {a, -b};
+        }
+
+        /// Multiplication by the non-residue xi = 9 + i
+        Fq2 mul_by_xi() const
+        {
+          const auto a8 = a.dbl().dbl().dbl();
+          const auto b8 = b.dbl().dbl().dbl();
+          return {a8 + a - b, b8 + b + a};
+        }
+
+        Fq2 inverse() const
+        {
+          const auto n = (a.square() + b.square()).inverse();
+          return {a * n, -(b * n)};
+        }
+
+        Fq2 pow(const uint256_t& e) const
+        {
+          const auto words = intx::as_words(e);
+          auto r = one();
+          for (int i = 255; i >= 0; --i)
+          {
+            r = r.square();
+            if ((words[i / 64] >> (i % 64)) & 1)
+              r = r * *this;
+          }
+          return r;
+        }
+      };
+
+      /// Fq2[v] / (v^3 - xi)
+      struct Fq6
+      {
+        Fq2 c0, c1, c2;
+
+        static Fq6 zero()
+        {
+          return {};
+        }
+
+        static Fq6 one()
+        {
+          return {Fq2::one(), {}, {}};
+        }
+
+        Fq6 operator+(const Fq6& o) const
+        {
+          return {c0 + o.c0, c1 + o.c1, c2 + o.c2};
+        }
+
+        Fq6 operator-(const Fq6& o) const
+        {
+          return {c0 - o.c0, c1 - o.c1, c2 - o.c2};
+        }
+
+        Fq6 operator-() const
+        {
+          return {-c0, -c1, -c2};
+        }
+
+        Fq6 operator*(const Fq6& o) const
+        {
+          const auto t0 = c0 * o.c0;
+          const auto t1 = c1 * o.c1;
+          const auto t2 = c2 * o.c2;
+          return {
+            ((c1 + c2) * (o.c1 + o.c2) - t1 - t2).mul_by_xi() + t0,
+            (c0 + c1) * (o.c0 + o.c1) - t0 - t1 + t2.mul_by_xi(),
+            (c0 + c2) * (o.c0 + o.c2) - t0 - t2 + t1};
+        }
+
+        Fq6 square() const
+        {
+          return *this * *this;
+        }
+
+        Fq6 mul_by_v() const
+        {
+          return {c2.mul_by_xi(), c0, c1};
+        }
+
+        Fq6 inverse() const
+        {
+          const auto t0 = c0.square() - (c1 * c2).mul_by_xi();
+          const auto t1 = c2.square().mul_by_xi() - c0 * c1;
+          const auto t2 = c1.square() - c0 * c2;
+          const auto n =
+            (c0 * t0 + (c2 * t1).mul_by_xi() + (c1 * t2).mul_by_xi()).inverse();
+          return {t0 * n, t1 * n, t2 * n};
+        }
+      };
+
+      /// Fq6[w] / (w^2 - v)
+      struct Fq12
+      {
+        Fq6 c0, c1;
+
+        static Fq12 one()
+        {
+          return {Fq6::one(), {}};
+        }
+
+        bool is_one() const
+        {
+          const auto o = Fq2::one();
+          return c0.c0 == o && c0.c1.is_zero() && c0.c2.is_zero() &&
+            c1.c0.is_zero() && c1.c1.is_zero() && c1.c2.is_zero();
+        }
+
+        Fq12 operator*(const Fq12& o) const
+        {
+          const auto t0 = c0 * o.c0;
+          const auto t1 = c1 * o.c1;
+          return {t0 + t1.mul_by_v(), (c0 + c1) * (o.c0 + o.c1) - t0 - t1};
+        }
+
+        Fq12 square() const
+        {
+          return *this * *this;
+        }
+
+        Fq12 conj() const
+        {
+          return {c0, -c1};
+        }
+
+        Fq12 inverse() const
+        {
+          const auto n = (c0.square() - c1.square().mul_by_v()).inverse();
+          return {c0 * n, -(c1 * n)};
+        }
+
+        /// Multiplication by a sparse element a + b w + c w^3, as produced by
+        /// line evaluation
+        Fq12 mul_by_line(const Fq2& a, const Fq2& b, const Fq2& c) const
+        {
+          return *this * Fq12{{a, {}, {}}, {b, c, {}}};
+        }
+
+        /// Raises to the power p. Writing this as sum(a_k w^k) over Fq2, each
+        /// term maps to conj(a_k) w^k xi^(k(p-1)/6).
+        Fq12 frobenius() const
+        {
+          static const auto gamma = [] {
+            array<Fq2, 6> g;
+            const auto g1 = Fq2{Fq(uint256_t(9)), Fq::one()}.pow(
+              (Fq::modulus() - 1) / 6);
+            g[0] = Fq2::one();
+            for (size_t k = 1; k < 6; ++k)
+              g[k] = g[k - 1] * g1;
+            return g;
+          }();
+
+          return {{c0.c0.conj(),
+                   c0.c1.conj() * gamma[2],
+                   c0.c2.conj() * gamma[4]},
+                  {c1.c0.conj() * gamma[1],
+                   c1.c1.conj() * gamma[3],
+                   c1.c2.conj() * gamma[5]}};
+        }
+
+        template <size_t N>
+        Fq12 pow(const uint64_t (&e)[N]) const
+        {
+          auto r = one();
+          for (int i = 64 * N - 1; i >= 0; --i)
+          {
+            r = r.square();
+            if ((e[i / 64] >> (i % 64)) & 1)
+              r = r * *this;
+          }
+          return r;
+        }
+      };
+
+      using G1 = JacobianPoint<Fq>;
+      using G2 = JacobianPoint<Fq2>;
+
+      /// Affine point on the twist, used by the Miller loop
+      struct AffineG2
+      {
+        Fq2 x, y;
+        bool infinity;
+      };
+
+      [[noreturn]] void invalid_input(const string& what)
+      {
+        throw Exception(Exception::Type::illegalInstruction, what);
+      }
+
+      Fq read_fq(ByteView input, size_t offset)
+      {
+        const auto v = read_word(input, offset);
+        if (v >= Fq::modulus())
+          invalid_input("alt_bn128 coordinate not less than field modulus");
+        return Fq(v);
+      }
+
+      /// Fq2 elements are encoded imaginary part first
+      Fq2 read_fq2(ByteView input, size_t offset)
+      {
+        const auto b = read_fq(input, offset);
+        const auto a = read_fq(input, offset + 32);
+        return {a, b};
+      }
+
+      /// (0, 0) encodes the point at infinity
+      G1 read_g1(ByteView input, size_t offset)
+      {
+        const auto x = read_fq(input, offset);
+        const auto y = read_fq(input, offset + 32);
+        if (x.is_zero() && y.is_zero())
+          return G1::infinity();
+
+        if (y.square() != x.square() * x + Fq(uint256_t(3)))
+          invalid_input("alt_bn128 point not on curve");
+        return G1::from_affine(x, y);
+      }
+
+      AffineG2 read_g2(ByteView input, size_t offset)
+      {
+        const auto x = read_fq2(input, offset);
+        const auto y = read_fq2(input, offset + 64);
+        if (x.is_zero() && y.is_zero())
+          return {x, y, true};
+
+        // The twist is y^2 = x^3 + 3 / xi
+        static const auto b2 = Fq2{Fq(uint256_t(3)), Fq::zero()} *
+          Fq2{Fq(uint256_t(9)), Fq::one()}.inverse();
+        if (y.square() != x.square() * x + b2)
+          invalid_input("alt_bn128 G2 point not on curve");
+
+        // Unlike G1, the twist has points outside the prime-order subgroup
+        if (!(G2::from_affine(x, y) * group_order()).is_infinity())
+          invalid_input("alt_bn128 G2 point not in subgroup");
+        return {x, y, false};
+      }
+
+      void write_g1(const G1& p, vector<uint8_t>& out)
+      {
+        if (p.is_infinity())
+        {
+          out.resize(out.size() + 64, 0);
+          return;
+        }
+
+        Fq x, y;
+        p.to_affine(x, y);
+        write_word(x.value(), out);
+        write_word(y.value(), out);
+      }
+
+      /**
+       * Miller loop state for one (P, Q) pair. Q is kept in affine
+       * coordinates on the twist; lines through T and Q are evaluated at P
+       * after untwisting (x, y) -> (x w^2, y w^3), giving
+       *   yP - lambda xP w + (lambda xT - yT) w^3
+       * where lambda is the slope on the twist. Vertical lines lie in Fq6 and
+       * are dropped, since the final exponentiation maps them to one.
+       */
+      struct MillerStep
+      {
+        Fq xp, yp;
+        AffineG2 t;
+
+        void line(Fq12& f, const Fq2& lambda) const
+        {
+          f = f.mul_by_line(
+            Fq2{yp, Fq::zero()}, -(lambda * xp), lambda * t.x - t.y);
+        }
+
+        void dbl(Fq12& f)
+        {
+          if (t.infinity)
+            return;
+          if (t.y.is_zero())
+          {
+            t.infinity = true;
+            return;
+          }
+
+          const auto x2 = t.x.square();
+          const auto lambda = (x2.dbl() + x2) * t.y.dbl().inverse();
+          line(f, lambda);
+          const auto x3 = lambda.square() - t.x.dbl();
+          t.y = lambda * (t.x - x3) - t.y;
+          t.x = x3;
+        }
+
+        void add(Fq12& f, const AffineG2& q)
+        {
+          if (q.infinity)
+            return;
+          if (t.infinity)
+          {
+            t = q;
+            return;
+          }
+          if (t.x == q.x)
+          {
+            if (t.y == q.y)
+              dbl(f);
+            else
+              t.infinity = true;
+            return;
+          }
+
+          const auto lambda = (q.y - t.y) * (q.x - t.x).inverse();
+          line(f, lambda);
+          const auto x3 = lambda.square() - t.x - q.x;
+          t.y = lambda * (t.x - x3) - t.y;
+          t.x = x3;
+        }
+      };
+
+      /// Frobenius on the twist: untwist, raise coordinates to the power p,
+      /// and twist back
+      AffineG2 twist_frobenius(const AffineG2& q)
+      {
+        static const auto gammas = [] {
+          const auto g1 =
+            Fq2{Fq(uint256_t(9)), Fq::one()}.pow((Fq::modulus() - 1) / 6);
+          const auto g2 = g1.square();
+          return make_pair(g2, g2 * g1);
+        }();
+        return {q.x.conj() * gammas.first, q.y.conj() * gammas.second, false};
+      }
+
+      Fq12 miller_loop(const G1& p, const AffineG2& q)
+      {
+        Fq xp, yp;
+        p.to_affine(xp, yp);
+        MillerStep step{xp, yp, q};
+
+        auto f = Fq12::one();
+        const uint64_t words[2] = {ATE_LOOP_COUNT_LO, ATE_LOOP_COUNT_HI};
+        for (int i = 64 + 64 - __builtin_clzll(ATE_LOOP_COUNT_HI) - 2; i >= 0;
+             --i)
+        {
+          f = f.square();
+          step.dbl(f);
+          if ((words[i / 64] >> (i % 64)) & 1)
+            step.add(f, q);
+        }
+
+        // Optimal ate correction terms, with Q1 = pi(Q) and Q2 = pi^2(Q)
+        const auto q1 = twist_frobenius(q);
+        auto q2 = twist_frobenius(q1);
+        q2.y = -q2.y;
+        step.add(f, q1);
+        step.add(f, q2);
+        return f;
+      }
+
+      Fq12 final_exponentiation(const Fq12& f)
+      {
+        // Easy part: f^((p^6 - 1)(p^2 + 1))
+        auto r = f.conj() * f.inverse();
+        r = r.frobenius().frobenius() * r;
+        // Hard part: (p^4 - p^2 + 1) / r
+        return r.pow(FINAL_EXPONENT);
+      }
+    } // namespace
+
+    vector<uint8_t> bn256_add(ByteView input)
+    {
+      const auto a = read_g1(input, 0);
+      const auto b = read_g1(input, 64);
+
+      vector<uint8_t> output;
+      output.reserve(64);
+      write_g1(a + b, output);
+      return output;
+    }
+
+    vector<uint8_t> bn256_mul(ByteView input)
+    {
+      const auto a = read_g1(input, 0);
+      const auto k = read_word(input, 64);
+
+      vector<uint8_t> output;
+      output.reserve(64);
+      write_g1(a * k, output);
+      return output;
+    }
+
+    vector<uint8_t> bn256_pairing(ByteView input)
+    {
+      constexpr size_t PAIR_SIZE = 192;
+      if (input.size() % PAIR_SIZE != 0)
+        invalid_input(
+          "alt_bn128 pairing input must be a multiple of 192 bytes");
+
+      auto f = Fq12::one();
+      for (size_t offset = 0; offset < input.size(); offset += PAIR_SIZE)
+      {
+        // Validate both points even if either is the identity
+        const auto p = read_g1(input, offset);
+        const auto q = read_g2(input, offset + 64);
+        if (p.is_infinity() || q.infinity)
+          continue;
+        f = f * miller_loop(p, q);
+      }
+
+      vector<uint8_t> output;
+      write_word(final_exponentiation(f).is_one() ? 1 : 0, output);
+      return output;
+    }
+  } // namespace precompiled
+} // namespace eevm
@@ -0,0 +1,78 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "eEVM/precompiled.h"
+
+#include <memory>
+
+using namespace std;
+
+namespace eevm
+{
+  namespace precompiled
+  {
+    vector<uint8_t> identity(ByteView input)
+    {
+      return {input.begin(), input.end()};
+    }
+  } // namespace precompiled
+
+  namespace
+  {
+    /// Words of input, for gas costs which scale per 32 bytes
+    uint64_t words(ByteView input)
+    {
+      return (input.size() + 31) / 32;
+    }
+
+    /// Identity writes its input straight to the output, rather than through
+    /// an intermediate vector
+    class IdentityContract : public NativeContract
+    {
+    public:
+      uint64_t gas(ByteView input) const override
+      {
+        return 15 + 3 * words(input);
+      }
+
+      void execute(ByteView input, NativeOutput& output) override
+      {
+        output.write(input);
+      }
+    };
+
+    NativeGasFunction fixed_gas(uint64_t gas)
+    {
+      return [gas](ByteView) { return gas; };
+    }
+
+    NativeGasFunction linear_gas(uint64_t base, uint64_t per_word)
+    {
+      return [base, per_word](ByteView input) {
+        return base + per_word * words(input);
+      };
+    }
+  } // namespace
+
+  // Gas costs follow Byzantium's schedule, which Constantinople kept
+  // (EIP-198 for modexp, EIP-196 and EIP-197 for alt_bn128). Later forks
+  // repriced these.
+  NativeContracts NativeContracts::standard(Fork fork)
+  {
+    NativeContracts nc;
+    nc.add(0x01, precompiled::ecrecover, fixed_gas(3000));
+    nc.add(0x02, precompiled::sha256, linear_gas(60, 12));
+    nc.add(0x03, precompiled::ripemd160, linear_gas(600, 120));
+    nc.add(0x04, make_shared<IdentityContract>());
+    if (max_standard_address(fork) < 0x05)
+      return nc;
+
+    nc.add(0x05, precompiled::modexp, precompiled::modexp_gas);
+    nc.add(0x06, precompiled::bn256_add, fixed_gas(500));
+    nc.add(0x07, precompiled::bn256_mul, fixed_gas(40000));
+    nc.add(0x08, precompiled::bn256_pairing, [](ByteView input) {
+      return 100000 + 80000 * uint64_t(input.size() / 192);
+    });
+    return nc;
+  }
+} // namespace eevm
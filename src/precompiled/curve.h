@@ -0,0 +1,119 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "eEVM/bigint.h"
+
+namespace eevm
+{
+  namespace precompiled
+  {
+    /**
+     * Point on a short Weierstrass curve y^2 = x^3 + b (ie, a = 0) over the
+     * field F, in Jacobian coordinates (x = X/Z^2, y = Y/Z^3). The point at
+     * infinity has Z = 0.
+     */
+    template <typename F>
+    struct JacobianPoint
+    {
+      F x, y, z;
+
+      static JacobianPoint infinity()
+      {
+        return {F::one(), F::one(), F::zero()};
+      }
+
+      static JacobianPoint from_affine(const F& x, const F& y)
+      {
+        return {x, y, F::one()};
+      }
+
+      bool is_infinity() const
+      {
+        return z.is_zero();
+      }
+
+      /// Affine coordinates. Must not be called on the point at infinity.
+      void to_affine(F& ax, F& ay) const
+      {
+        const auto zinv = z.inverse();
+        const auto zinv2 = zinv.square();
+        ax = x * zinv2;
+        ay = y * zinv2 * zinv;
+      }
+
+      JacobianPoint dbl() const
+      {
+        if (is_infinity())
+          return *this;
+
+        // dbl-2009-l
+        const auto a = x.square();
+        const auto b = y.square();
+        const auto c = b.square();
+        const auto d = ((x + b).square() - a - c).dbl();
+        const auto e = a.dbl() + a;
+        const auto f = e.square();
+        const auto x3 = f - d.dbl();
+        const auto y3 = e * (d - x3) - c.dbl().dbl().dbl();
+        const auto z3 = (y * z).dbl();
+        return {x3, y3, z3};
+      }
+
+      JacobianPoint operator+(const JacobianPoint& o) const
+      {
+        if (is_infinity())
+          return o;
+        if (o.is_infinity())
+          return *this;
+
+        // add-2007-bl
+        const auto z1z1 = z.square();
+        const auto z2z2 = o.z.square();
+        const auto u1 = x * z2z2;
+        const auto u2 = o.x * z1z1;
+        const auto s1 = y * o.z * z2z2;
+        const auto s2 = o.y * z * z1z1;
+        const auto h = u2 - u1;
+        const auto r = (s2 - s1).dbl();
+
+        if (h.is_zero())
+          return r.is_zero() ? dbl() : infinity();
+
+        const auto i = h.dbl().square();
+        const auto j = h * i;
+        const auto v = u1 * i;
+        const auto x3 = r.square() - j - v.dbl();
+        const auto y3 = r * (v - x3) - (s1 * j).dbl();
+        const auto z3 = ((z + o.z).square() - z1z1 - z2z2) * h;
+        return {x3, y3, z3};
+      }
+
+      JacobianPoint operator-() const
+      {
+        return {x, -y, z};
+      }
+
+      /// Scalar multiplication, using a fixed 4-bit window
+      JacobianPoint operator*(const uint256_t& k) const
+      {
+        JacobianPoint table[16];
+        table[0] = infinity();
+        for (size_t i = 1; i < 16; ++i)
+          table[i] = table[i - 1] + *this;
+
+        const auto words = intx::as_words(k);
+        auto r = infinity();
+        for (int nibble = 63; nibble >= 0; --nibble)
+        {
+          r = r.dbl().dbl().dbl().dbl();
+          const auto bits = (words[nibble / 16] >> (4 * (nibble % 16))) & 0xf;
+          if (bits != 0)
+            r = r + table[bits];
+        }
+        return r;
+      }
+    };
+  } // namespace precompiled
+} // namespace eevm
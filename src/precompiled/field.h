@@ -0,0 +1,273 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "eEVM/bigint.h"
+
+#include <cstdint>
+
+namespace eevm
+{
+  namespace precompiled
+  {
+    /**
+     * Little-endian 64-bit limbs of a 256-bit value. Kept separate from
+     * uint256_t so that field constants can be derived at compile time.
+     */
+    struct Limbs
+    {
+      uint64_t w[4];
+    };
+
+    constexpr bool limbs_ge(const Limbs& a, const Limbs& b)
+    {
+      for (int i = 3; i >= 0; --i)
+      {
+        if (a.w[i] != b.w[i])
+          return a.w[i] > b.w[i];
+      }
+      return true;
+    }
+
+    /// r = a - b, returning the borrow
+    constexpr uint64_t limbs_sub(Limbs& r, const Limbs& a, const Limbs& b)
+    {
+      uint64_t borrow = 0;
+      for (int i = 0; i < 4; ++i)
+      {
+        const auto d = a.w[i] - b.w[i];
+        const auto next = (a.w[i] < b.w[i]) | (d < borrow);
+        r.w[i] = d - borrow;
+        borrow = next;
+      }
+      return borrow;
+    }
+
+    /// r = a + b, returning the carry
+    constexpr uint64_t limbs_add(Limbs& r, const Limbs& a, const Limbs& b)
+    {
+      uint64_t carry = 0;
+      for (int i = 0; i < 4; ++i)
+      {
+        const auto s = a.w[i] + b.w[i];
+        const auto next = (s < a.w[i]) | (s + carry < s);
+        r.w[i] = s + carry;
+        carry = next;
+      }
+      return carry;
+    }
+
+    /// (a + b) mod m, for a, b < m
+    constexpr Limbs limbs_addmod(const Limbs& a, const Limbs& b, const Limbs& m)
+    {
+      Limbs r{};
+      const auto carry = limbs_add(r, a, b);
+      if (carry || limbs_ge(r, m))
+        limbs_sub(r, r, m);
+      return r;
+    }
+
+    /// -m^-1 mod 2^64, by Newton iteration
+    constexpr uint64_t neg_inverse_64(uint64_t m0)
+    {
+      uint64_t inv = 1;
+      for (int i = 0; i < 6; ++i)
+        inv *= 2 - m0 * inv;
+      return 0 - inv;
+    }
+
+    /// 2^512 mod m, by repeated doubling
+    constexpr Limbs montgomery_r2(const Limbs& m)
+    {
+      Limbs r{{1, 0, 0, 0}};
+      for (int i = 0; i < 512; ++i)
+        r = limbs_addmod(r, r, m);
+      return r;
+    }
+
+    /**
+     * Element of the prime field defined by P::modulus (which must be odd and
+     * less than 2^256), held in Montgomery form so that multiplication needs
+     * no division.
+     */
+    template <typename P>
+    class Fp
+    {
+      static constexpr Limbs M = P::modulus;
+      static constexpr uint64_t N0 = neg_inverse_64(P::modulus.w[0]);
+      static constexpr Limbs R2 = montgomery_r2(P::modulus);
+
+      Limbs v{};
+
+      static Limbs mont_mul(const Limbs& a, const Limbs& b)
+      {
+        // Coarsely integrated operand scanning (CIOS)
+        uint64_t t[6] = {};
+        for (int i = 0; i < 4; ++i)
+        {
+          uint64_t c = 0;
+          for (int j = 0; j < 4; ++j)
+          {
+            const auto p =
+              intx::umul(a.w[j], b.w[i]) + intx::uint128(t[j]) + c;
+            t[j] = p.lo;
+            c = p.hi;
+          }
+          auto s = intx::uint128(t[4]) + c;
+          t[4] = s.lo;
+          t[5] = s.hi;
+
+          const uint64_t m = t[0] * N0;
+          auto p = intx::umul(m, M.w[0]) + intx::uint128(t[0]);
+          c = p.hi;
+          for (int j = 1; j < 4; ++j)
+          {
+            p = intx::umul(m, M.w[j]) + intx::uint128(t[j]) + c;
+            t[j - 1] = p.lo;
+            c = p.hi;
+          }
+          s = intx::uint128(t[4]) + c;
+          t[3] = s.lo;
+          t[4] = t[5] + s.hi;
+        }
+
+        Limbs r{{t[0], t[1], t[2], t[3]}};
+        if (t[4] || limbs_ge(r, M))
+          limbs_sub(r, r, M);
+        return r;
+      }
+
+      struct Raw
+      {};
+      constexpr Fp(const Limbs& l, Raw) : v(l) {}
+
+    public:
+      constexpr Fp() = default;
+
+      /// Converts from a canonical integer, which must be less than modulus
+      explicit Fp(const uint256_t& x)
+      {
+        Limbs l{};
+        const auto words = intx::as_words(x);
+        for (int i = 0; i < 4; ++i)
+          l.w[i] = words[i];
+        v = mont_mul(l, R2);
+      }
+
+      static Fp zero()
+      {
+        return {};
+      }
+
+      static Fp one()
+      {
+        return Fp(uint256_t(1));
+      }
+
+      static uint256_t modulus()
+      {
+        uint256_t m;
+        auto words = intx::as_words(m);
+        for (int i = 0; i < 4; ++i)
+          words[i] = M.w[i];
+        return m;
+      }
+
+      /// Canonical integer value
+      uint256_t value() const
+      {
+        const auto l = mont_mul(v, Limbs{{1, 0, 0, 0}});
+        uint256_t x;
+        auto words = intx::as_words(x);
+        for (int i = 0; i < 4; ++i)
+          words[i] = l.w[i];
+        return x;
+      }
+
+      bool is_zero() const
+      {
+        return (v.w[0] | v.w[1] | v.w[2] | v.w[3]) == 0;
+      }
+
+      bool operator==(const Fp& o) const
+      {
+        return v.w[0] == o.v.w[0] && v.w[1] == o.v.w[1] &&
+          v.w[2] == o.v.w[2] && v.w[3] == o.v.w[3];
+      }
+
+      bool operator!=(const Fp& o) const
+      {
+        return !(*this == o);
+      }
+
+      Fp operator+(const Fp& o) const
+      {
+        return {limbs_addmod(v, o.v, M), Raw{}};
+      }
+
+      Fp operator-(const Fp& o) const
+      {
+        Limbs r{};
+        if (limbs_sub(r, v, o.v))
+          limbs_add(r, r, M);
+        return {r, Raw{}};
+      }
+
+      Fp operator-() const
+      {
+        return zero() - *this;
+      }
+
+      Fp operator*(const Fp& o) const
+      {
+        return {mont_mul(v, o.v), Raw{}};
+      }
+
+      Fp& operator+=(const Fp& o)
+      {
+        return *this = *this + o;
+      }
+
+      Fp& operator-=(const Fp& o)
+      {
+        return *this = *this - o;
+      }
+
+      Fp& operator*=(const Fp& o)
+      {
+        return *this = *this * o;
+      }
+
+      Fp square() const
+      {
+        return *this * *this;
+      }
+
+      Fp dbl() const
+      {
+        return *this + *this;
+      }
+
+      Fp pow(const uint256_t& e) const
+      {
+        const auto words = intx::as_words(e);
+        Fp r = one();
+        for (int i = 255; i >= 0; --i)
+        {
+          r = r.square();
+          if ((words[i / 64] >> (i % 64)) & 1)
+            r *= *this;
+        }
+        return r;
+      }
+
+      /// Multiplicative inverse by Fermat's little theorem. Inverse of zero
+      /// is zero.
+      Fp inverse() const
+      {
+        return pow(modulus() - 2);
+      }
+    };
+  } // namespace precompiled
+} // namespace eevm
@@ -0,0 +1,44 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "eEVM/nativecontract.h"
+#include "eEVM/util.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace eevm
+{
+  namespace precompiled
+  {
+    /// Copies size bytes of input from offset, treating input as if it were
+    /// infinitely right-padded with zeroes (as precompiles must)
+    inline void read_padded(
+      ByteView input, size_t offset, uint8_t* out, size_t size)
+    {
+      std::memset(out, 0, size);
+      if (offset < input.size())
+        std::memcpy(
+          out,
+          input.data() + offset,
+          std::min(size, input.size() - offset));
+    }
+
+    inline uint256_t read_word(ByteView input, size_t offset)
+    {
+      uint8_t word[32];
+      read_padded(input, offset, word, sizeof(word));
+      return from_big_endian(word);
+    }
+
+    inline void write_word(const uint256_t& v, std::vector<uint8_t>& out)
+    {
+      const auto offset = out.size();
+      out.resize(offset + 32);
+      to_big_endian(v, out.data() + offset);
+    }
+  } // namespace precompiled
+} // namespace eevm
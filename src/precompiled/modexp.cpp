@@ -0,0 +1,401 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "eEVM/exception.h"
+#include "eEVM/precompiled.h"
+#include "input.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+namespace eevm
+{
+  namespace precompiled
+  {
+    namespace
+    {
+      /// There is no gas accounting to bound the work done, so operand sizes
+      /// (in bytes) are capped instead
+      constexpr size_t MAX_OPERAND_SIZE = 1024;
+
+      /// Arbitrary-precision natural number, as little-endian 64-bit limbs
+      using Nat = vector<uint64_t>;
+
+      size_t read_size(ByteView input, size_t offset)
+      {
+        const auto size = read_word(input, offset);
+        if (size > MAX_OPERAND_SIZE)
+          throw Exception(
+            Exception::Type::outOfBounds,
+            "modexp operand size exceeds " + to_string(MAX_OPERAND_SIZE) +
+              " bytes");
+        return static_cast<size_t>(size);
+      }
+
+      uint8_t byte_at(ByteView input, size_t offset)
+      {
+        return offset < input.size() ? input[offset] : 0;
+      }
+
+      /// Reads a big-endian operand of size bytes
+      Nat read_nat(ByteView input, size_t offset, size_t size)
+      {
+        Nat n((size + 7) / 8, 0);
+        for (size_t k = 0; k < size; ++k)
+        {
+          const uint64_t b = byte_at(input, offset + size - 1 - k);
+          n[k / 8] |= b << (8 * (k % 8));
+        }
+        return n;
+      }
+
+      void trim(Nat& n)
+      {
+        while (!n.empty() && n.back() == 0)
+          n.pop_back();
+      }
+
+      /// u mod v, by Knuth's algorithm D. v must be trimmed and non-zero. The
+      /// result has exactly as many limbs as v.
+      Nat mod(const Nat& u, const Nat& v)
+      {
+        const auto n = v.size();
+        if (u.size() < n)
+        {
+          Nat r = u;
+          r.resize(n, 0);
+          return r;
+        }
+
+        if (n == 1)
+        {
+          uint64_t r = 0;
+          for (auto i = u.size(); i-- > 0;)
+            r = static_cast<uint64_t>(
+              intx::udivrem(intx::uint128{r, u[i]}, intx::uint128(v[0])).rem);
+          return {r};
+        }
+
+        // Normalise so that the top limb of the divisor has its high bit set
+        const auto s = intx::clz(v.back());
+        Nat vn(n), un(u.size() + 1);
+        for (size_t i = n - 1; i > 0; --i)
+          vn[i] = s ? (v[i] << s) | (v[i - 1] >> (64 - s)) : v[i];
+        vn[0] = v[0] << s;
+        un[u.size()] = s ? u.back() >> (64 - s) : 0;
+        for (size_t i = u.size() - 1; i > 0; --i)
+          un[i] = s ? (u[i] << s) | (u[i - 1] >> (64 - s)) : u[i];
+        un[0] = u[0] << s;
+
+        const intx::uint128 base = intx::uint128{1, 0};
+        for (auto j = u.size() - n + 1; j-- > 0;)
+        {
+          // Estimate the quotient limb from the top two limbs, then correct
+          // it (at most twice) using the third
+          const intx::uint128 num{un[j + n], un[j + n - 1]};
+          auto qr = intx::udivrem(num, intx::uint128(vn[n - 1]));
+          auto qhat = qr.quot;
+          auto rhat = qr.rem;
+          while (qhat >= base ||
+                 intx::umul(qhat.lo, vn[n - 2]) >
+                   intx::uint128{rhat.lo, un[j + n - 2]})
+          {
+            --qhat;
+            rhat += vn[n - 1];
+            if (rhat >= base)
+              break;
+          }
+
+          // un[j..j+n] -= qhat * vn
+          uint64_t borrow = 0, carry = 0;
+          for (size_t i = 0; i < n; ++i)
+          {
+            const auto p = intx::umul(qhat.lo, vn[i]) + carry;
+            carry = p.hi;
+            const auto t = un[i + j] - p.lo;
+            const auto b = un[i + j] < p.lo;
+            un[i + j] = t - borrow;
+            borrow = b | (t < borrow);
+          }
+          const auto t = un[j + n] - carry;
+          const auto b = un[j + n] < carry;
+          un[j + n] = t - borrow;
+          borrow = b | (t < borrow);
+
+          // qhat was one too large: add the divisor back
+          if (borrow)
+          {
+            uint64_t c = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+              const auto sum = intx::uint128(un[i + j]) + vn[i] + c;
+              un[i + j] = sum.lo;
+              c = sum.hi;
+            }
+            un[j + n] += c;
+          }
+        }
+
+        // Denormalise the remainder
+        Nat r(n);
+        for (size_t i = 0; i < n; ++i)
+          r[i] = s ? (un[i] >> s) | (un[i + 1] << (64 - s)) : un[i];
+        return r;
+      }
+
+      Nat mul(const Nat& a, const Nat& b)
+      {
+        Nat r(a.size() + b.size(), 0);
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+          uint64_t c = 0;
+          for (size_t j = 0; j < b.size(); ++j)
+          {
+            const auto p = intx::umul(a[i], b[j]) + r[i + j] + c;
+            r[i + j] = p.lo;
+            c = p.hi;
+          }
+          r[i + b.size()] = c;
+        }
+        return r;
+      }
+
+      /// Multiplication modulo any non-zero m
+      struct PlainReducer
+      {
+        const Nat& m;
+
+        Nat to_domain(const Nat& a) const
+        {
+          return a;
+        }
+
+        Nat from_domain(const Nat& a) const
+        {
+          return a;
+        }
+
+        Nat one() const
+        {
+          return mod(Nat{1}, m);
+        }
+
+        Nat mul(const Nat& a, const Nat& b) const
+        {
+          return mod(precompiled::mul(a, b), m);
+        }
+      };
+
+      /// Montgomery multiplication modulo an odd m, with R = 2^(64 * limbs)
+      struct MontgomeryReducer
+      {
+        const Nat& m;
+        uint64_t n0 = 0;
+        Nat r2;
+
+        MontgomeryReducer(const Nat& m_) : m(m_)
+        {
+          // -m^-1 mod 2^64, by Newton iteration
+          uint64_t inv = 1;
+          for (int i = 0; i < 6; ++i)
+            inv *= 2 - m[0] * inv;
+          n0 = 0 - inv;
+
+          Nat r2_num(2 * m.size() + 1, 0);
+          r2_num.back() = 1;
+          r2 = mod(r2_num, m);
+        }
+
+        Nat to_domain(const Nat& a) const
+        {
+          return mul(a, r2);
+        }
+
+        Nat from_domain(const Nat& a) const
+        {
+          Nat one(m.size(), 0);
+          one[0] = 1;
+          return mul(a, one);
+        }
+
+        Nat one() const
+        {
+          Nat r_num(m.size() + 1, 0);
+          r_num.back() = 1;
+          return mod(r_num, m);
+        }
+
+        /// Coarsely integrated operand scanning, as in Fp
+        Nat mul(const Nat& a, const Nat& b) const
+        {
+          const auto n = m.size();
+          Nat t(n + 2, 0);
+          for (size_t i = 0; i < n; ++i)
+          {
+            uint64_t c = 0;
+            for (size_t j = 0; j < n; ++j)
+            {
+              const auto p = intx::umul(a[j], b[i]) + t[j] + c;
+              t[j] = p.lo;
+              c = p.hi;
+            }
+            auto s = intx::uint128(t[n]) + c;
+            t[n] = s.lo;
+            t[n + 1] = s.hi;
+
+            const uint64_t q = t[0] * n0;
+            auto p = intx::umul(q, m[0]) + t[0];
+            c = p.hi;
+            for (size_t j = 1; j < n; ++j)
+            {
+              p = intx::umul(q, m[j]) + t[j] + c;
+              t[j - 1] = p.lo;
+              c = p.hi;
+            }
+            s = intx::uint128(t[n]) + c;
+            t[n - 1] = s.lo;
+            t[n] = t[n + 1] + s.hi;
+          }
+
+          // Conditional final subtraction
+          bool ge = t[n] != 0;
+          if (!ge)
+          {
+            ge = true;
+            for (auto i = n; i-- > 0;)
+            {
+              if (t[i] != m[i])
+              {
+                ge = t[i] > m[i];
+                break;
+              }
+            }
+          }
+          t.resize(n);
+          if (ge)
+          {
+            uint64_t borrow = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+              const auto d = t[i] - m[i];
+              const auto b = t[i] < m[i];
+              t[i] = d - borrow;
+              borrow = b | (d < borrow);
+            }
+          }
+          return t;
+        }
+      };
+
+      /// Left-to-right square-and-multiply, reading exponent bits directly
+      /// from the (padded) input
+      template <typename Reducer>
+      Nat mod_pow(
+        const Reducer& red,
+        const Nat& base,
+        ByteView input,
+        size_t e_offset,
+        size_t e_size)
+      {
+        const auto b = red.to_domain(base);
+        auto acc = red.one();
+        for (size_t i = 0; i < e_size; ++i)
+        {
+          const auto byte = byte_at(input, e_offset + i);
+          for (int bit = 7; bit >= 0; --bit)
+          {
+            acc = red.mul(acc, acc);
+            if ((byte >> bit) & 1)
+              acc = red.mul(acc, b);
+          }
+        }
+        return red.from_domain(acc);
+      }
+    } // namespace
+
+    uint64_t modexp_gas(ByteView input)
+    {
+      constexpr auto max_gas = numeric_limits<uint64_t>::max();
+
+      // Operands this large could never be paid for
+      constexpr uint64_t size_limit = 1ull << 30;
+      const auto b_size = read_word(input, 0);
+      const auto e_size = read_word(input, 32);
+      const auto m_size = read_word(input, 64);
+      if (b_size > size_limit || e_size > size_limit || m_size > size_limit)
+        return max_gas;
+
+      const auto bs = static_cast<uint64_t>(b_size);
+      const auto es = static_cast<uint64_t>(e_size);
+      const auto ms = static_cast<uint64_t>(m_size);
+
+      // Multiplication complexity, by the size in bytes of the larger of the
+      // base and modulus
+      const auto x = max(bs, ms);
+      uint64_t complexity;
+      if (x <= 64)
+        complexity = x * x;
+      else if (x <= 1024)
+        complexity = x * x / 4 + 96 * x - 3072;
+      else
+        complexity = x * x / 16 + 480 * x - 199680;
+
+      // Iterations depend on the bit length of the exponent's first word, and
+      // on how many bytes follow it
+      uint8_t head[32];
+      const auto head_size = static_cast<size_t>(min<uint64_t>(es, 32));
+      read_padded(input, 96 + bs, head, head_size);
+      const auto e_head = from_big_endian(head, head_size);
+      const uint64_t head_bits = 256 - intx::clz(e_head);
+      uint64_t iterations = head_bits > 0 ? head_bits - 1 : 0;
+      if (es > 32)
+        iterations += 8 * (es - 32);
+      iterations = max<uint64_t>(iterations, 1);
+
+      const auto gas = intx::umul(complexity, iterations) / 20;
+      if (gas.hi != 0)
+        return max_gas;
+      return gas.lo;
+    }
+
+    vector<uint8_t> modexp(ByteView input)
+    {
+      const auto b_size = read_size(input, 0);
+      const auto e_size = read_size(input, 32);
+      const auto m_size = read_size(input, 64);
+
+      const size_t b_offset = 96;
+      const auto e_offset = b_offset + b_size;
+      const auto m_offset = e_offset + e_size;
+
+      vector<uint8_t> output(m_size, 0);
+      auto m = read_nat(input, m_offset, m_size);
+      trim(m);
+      if (m.empty())
+        return output;
+
+      // Leading zero bytes of the exponent only square one
+      size_t e_start = 0;
+      while (e_start < e_size && byte_at(input, e_offset + e_start) == 0)
+        ++e_start;
+
+      auto b = read_nat(input, b_offset, b_size);
+      trim(b);
+      b = mod(b, m);
+
+      const auto e_bits_offset = e_offset + e_start;
+      const auto e_bits_size = e_size - e_start;
+      const auto r = (m[0] & 1) ?
+        mod_pow(MontgomeryReducer(m), b, input, e_bits_offset, e_bits_size) :
+        mod_pow(PlainReducer{m}, b, input, e_bits_offset, e_bits_size);
+
+      // Write the result big-endian, right-aligned in m_size bytes
+      for (size_t k = 0; k < m_size && k / 8 < r.size(); ++k)
+        output[m_size - 1 - k] =
+          static_cast<uint8_t>(r[k / 8] >> (8 * (k % 8)));
+      return output;
+    }
+  } // namespace precompiled
+} // namespace eevm
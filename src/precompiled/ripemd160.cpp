@@ -0,0 +1,137 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "eEVM/precompiled.h"
+
+#include <cstring>
+
+using namespace std;
+
+namespace eevm
+{
+  namespace precompiled
+  {
+    namespace
+    {
+      // Message word selection and rotation amounts for the left and right
+      // lines, five rounds of sixteen steps each
+      constexpr uint8_t RL[80] = {
+        0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15,
+        7,  4,  13, 1,  10, 6,  15, 3,  12, 0,  9,  5,  2,  14, 11, 8,
+        3,  10, 14, 4,  9,  15, 8,  1,  2,  7,  0,  6,  13, 11, 5,  12,
+        1,  9,  11, 10, 0,  8,  12, 4,  13, 3,  7,  15, 14, 5,  6,  2,
+        4,  0,  5,  9,  7,  12, 2,  10, 14, 1,  3,  8,  11, 6,  15, 13};
+      constexpr uint8_t RR[80] = {
+        5,  14, 7,  0,  9,  2,  11, 4,  13, 6,  15, 8,  1,  10, 3,  12,
+        6,  11, 3,  7,  0,  13, 5,  10, 14, 15, 8,  12, 4,  9,  1,  2,
+        15, 5,  1,  3,  7,  14, 6,  9,  11, 8,  12, 2,  10, 0,  4,  13,
+        8,  6,  4,  1,  3,  11, 15, 0,  5,  12, 2,  13, 9,  7,  10, 14,
+        12, 15, 10, 4,  1,  5,  8,  7,  6,  2,  13, 14, 0,  3,  9,  11};
+      constexpr uint8_t SL[80] = {
+        11, 14, 15, 12, 5,  8,  7,  9,  11, 13, 14, 15, 6,  7,  9,  8,
+        7,  6,  8,  13, 11, 9,  7,  15, 7,  12, 15, 9,  11, 7,  13, 12,
+        11, 13, 6,  7,  14, 9,  13, 15, 14, 8,  13, 6,  5,  12, 7,  5,
+        11, 12, 14, 15, 14, 15, 9,  8,  9,  14, 5,  6,  8,  6,  5,  12,
+        9,  15, 5,  11, 6,  8,  13, 12, 5,  12, 13, 14, 11, 8,  5,  6};
+      constexpr uint8_t SR[80] = {
+        8,  9,  9,  11, 13, 15, 15, 5,  7,  7,  8,  11, 14, 14, 12, 6,
+        9,  13, 15, 7,  12, 8,  9,  11, 7,  7,  12, 7,  6,  15, 13, 11,
+        9,  7,  15, 11, 8,  6,  6,  14, 12, 13, 5,  14, 13, 13, 7,  5,
+        15, 5,  8,  11, 14, 14, 6,  14, 6,  9,  12, 9,  12, 5,  15, 8,
+        8,  5,  12, 9,  12, 5,  14, 6,  8,  13, 6,  5,  15, 13, 11, 11};
+      constexpr uint32_t KL[5] = {
+        0x00000000, 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xa953fd4e};
+      constexpr uint32_t KR[5] = {
+        0x50a28be6, 0x5c4dd124, 0x6d703ef3, 0x7a6d76e9, 0x00000000};
+
+      inline uint32_t rotl(uint32_t x, int n)
+      {
+        return (x << n) | (x >> (32 - n));
+      }
+
+      inline uint32_t f(int j, uint32_t x, uint32_t y, uint32_t z)
+      {
+        switch (j / 16)
+        {
+          case 0:
+            return x ^ y ^ z;
+          case 1:
+            return (x & y) | (~x & z);
+          case 2:
+            return (x | ~y) ^ z;
+          case 3:
+            return (x & z) | (y & ~z);
+          default:
+            return x ^ (y | ~z);
+        }
+      }
+
+      void compress(uint32_t (&h)[5], const uint8_t* block)
+      {
+        uint32_t x[16];
+        for (size_t i = 0; i < 16; ++i)
+          x[i] = uint32_t(block[4 * i]) | (uint32_t(block[4 * i + 1]) << 8) |
+            (uint32_t(block[4 * i + 2]) << 16) |
+            (uint32_t(block[4 * i + 3]) << 24);
+
+        auto al = h[0], bl = h[1], cl = h[2], dl = h[3], el = h[4];
+        auto ar = h[0], br = h[1], cr = h[2], dr = h[3], er = h[4];
+        for (int j = 0; j < 80; ++j)
+        {
+          auto t = rotl(al + f(j, bl, cl, dl) + x[RL[j]] + KL[j / 16], SL[j]) +
+            el;
+          al = el;
+          el = dl;
+          dl = rotl(cl, 10);
+          cl = bl;
+          bl = t;
+
+          t = rotl(ar + f(79 - j, br, cr, dr) + x[RR[j]] + KR[j / 16], SR[j]) +
+            er;
+          ar = er;
+          er = dr;
+          dr = rotl(cr, 10);
+          cr = br;
+          br = t;
+        }
+
+        const auto t = h[1] + cl + dr;
+        h[1] = h[2] + dl + er;
+        h[2] = h[3] + el + ar;
+        h[3] = h[4] + al + br;
+        h[4] = h[0] + bl + cr;
+        h[0] = t;
+      }
+    } // namespace
+
+    vector<uint8_t> ripemd160(ByteView input)
+    {
+      uint32_t h[5] = {
+        0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+
+      const auto full_blocks = input.size() / 64;
+      for (size_t i = 0; i < full_blocks; ++i)
+        compress(h, input.data() + 64 * i);
+
+      // Same padding as SHA-256, but the length is little-endian
+      uint8_t tail[128] = {};
+      const auto rem = input.size() - full_blocks * 64;
+      if (rem > 0)
+        memcpy(tail, input.data() + full_blocks * 64, rem);
+      tail[rem] = 0x80;
+      const size_t tail_len = rem < 56 ? 64 : 128;
+      const uint64_t bits = uint64_t(input.size()) * 8;
+      for (size_t i = 0; i < 8; ++i)
+        tail[tail_len - 8 + i] = static_cast<uint8_t>(bits >> (8 * i));
+      for (size_t i = 0; i < tail_len; i += 64)
+        compress(h, tail + i);
+
+      // The 20-byte digest is left-padded to a full word
+      vector<uint8_t> output(32, 0);
+      for (size_t i = 0; i < 5; ++i)
+        for (size_t j = 0; j < 4; ++j)
+          output[12 + 4 * i + j] = static_cast<uint8_t>(h[i] >> (8 * j));
+      return output;
+    }
+  } // namespace precompiled
+} // namespace eevm
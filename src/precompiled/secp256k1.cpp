@@ -0,0 +1,115 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "curve.h"
+#include "eEVM/precompiled.h"
+#include "field.h"
+#include "input.h"
+
+using namespace std;
+
+namespace eevm
+{
+  namespace precompiled
+  {
+    namespace
+    {
+      struct Secp256k1Prime
+      {
+        static constexpr Limbs modulus{{0xfffffffefffffc2full,
+                                        0xffffffffffffffffull,
+                                        0xffffffffffffffffull,
+                                        0xffffffffffffffffull}};
+      };
+
+      struct Secp256k1Order
+      {
+        static constexpr Limbs modulus{{0xbfd25e8cd0364141ull,
+                                        0xbaaedce6af48a03bull,
+                                        0xfffffffffffffffeull,
+                                        0xffffffffffffffffull}};
+      };
+
+      using Fq = Fp<Secp256k1Prime>;
+      using Fn = Fp<Secp256k1Order>;
+      using Point = JacobianPoint<Fq>;
+
+      const Point& generator()
+      {
+        static const Point g = Point::from_affine(
+          Fq(intx::from_string<uint256_t>(
+            "0x79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798")),
+          Fq(intx::from_string<uint256_t>(
+            "0x483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8")));
+        return g;
+      }
+
+      /// u1 * G + u2 * R, sharing doublings between the two (Shamir's trick).
+      /// Signature recovery only involves public values, so this need not be
+      /// constant-time.
+      Point double_mul(const uint256_t& u1, const Point& r, const uint256_t& u2)
+      {
+        const auto& g = generator();
+        const Point table[4] = {Point::infinity(), g, r, g + r};
+
+        const auto w1 = intx::as_words(u1);
+        const auto w2 = intx::as_words(u2);
+        auto acc = Point::infinity();
+        for (int i = 255; i >= 0; --i)
+        {
+          acc = acc.dbl();
+          const auto b1 = (w1[i / 64] >> (i % 64)) & 1;
+          const auto b2 = (w2[i / 64] >> (i % 64)) & 1;
+          const auto idx = b1 | (b2 << 1);
+          if (idx != 0)
+            acc = acc + table[idx];
+        }
+        return acc;
+      }
+    } // namespace
+
+    vector<uint8_t> ecrecover(ByteView input)
+    {
+      const auto hash = read_word(input, 0);
+      const auto v = read_word(input, 32);
+      const auto r = read_word(input, 64);
+      const auto s = read_word(input, 96);
+
+      // Invalid signatures are not errors; they produce empty output
+      const auto n = Fn::modulus();
+      if ((v != 27 && v != 28) || r == 0 || r >= n || s == 0 || s >= n)
+        return {};
+
+      // Recover R from its x coordinate (r) and the parity of y (v)
+      const Fq x(r);
+      const auto y2 = x.square() * x + Fq(uint256_t(7));
+      // p = 3 mod 4, so a square root (if any) is y2^((p+1)/4)
+      auto y = y2.pow((Fq::modulus() + 1) >> 2);
+      if (y.square() != y2)
+        return {};
+      if (static_cast<uint64_t>(y.value() & 1) != static_cast<uint64_t>(v - 27))
+        y = -y;
+
+      // Q = r^-1 (s R - e G)
+      const auto r_inv = Fn(r).inverse();
+      const auto e = Fn(hash % n);
+      const auto u1 = (-e * r_inv).value();
+      const auto u2 = (Fn(s) * r_inv).value();
+      const auto q = double_mul(u1, Point::from_affine(x, y), u2);
+      if (q.is_infinity())
+        return {};
+
+      Fq qx, qy;
+      q.to_affine(qx, qy);
+      uint8_t pub[64];
+      to_big_endian(qx.value(), pub);
+      to_big_endian(qy.value(), pub + 32);
+      const auto h = keccak_256(pub, sizeof(pub));
+
+      // Address is the low 20 bytes of the hash, left-padded to a full word
+      vector<uint8_t> output(32, 0);
+      copy(h.begin() + 12, h.end(), output.begin() + 12);
+      return output;
+    }
+  } // namespace precompiled
+} // namespace eevm
@@ -0,0 +1,144 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "sha256.h"
+
+#include "eEVM/precompiled.h"
+
+#include <cstring>
+
+#ifdef EEVM_SHA_NI
+#  include <cpuid.h>
+#endif
+
+using namespace std;
+
+namespace eevm
+{
+  namespace precompiled
+  {
+    namespace
+    {
+      constexpr uint32_t K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+        0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+        0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+        0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+        0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+        0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+        0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+        0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+        0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+      inline uint32_t rotr(uint32_t x, int n)
+      {
+        return (x >> n) | (x << (32 - n));
+      }
+
+      inline uint32_t load_be32(const uint8_t* p)
+      {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) |
+          (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+      }
+
+      Sha256Compress select_compress()
+      {
+#ifdef EEVM_SHA_NI
+        unsigned int a, b, c, d;
+        if (__get_cpuid_count(7, 0, &a, &b, &c, &d) && (b & (1u << 29)))
+          return sha256_compress_shani;
+#endif
+        return sha256_compress_generic;
+      }
+    } // namespace
+
+    void sha256_compress_generic(uint32_t* state, const uint8_t* data, size_t n)
+    {
+      for (; n > 0; --n, data += 64)
+      {
+        uint32_t w[64];
+        for (size_t i = 0; i < 16; ++i)
+          w[i] = load_be32(data + 4 * i);
+        for (size_t i = 16; i < 64; ++i)
+        {
+          const auto s0 =
+            rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+          const auto s1 =
+            rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+          w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        auto a = state[0], b = state[1], c = state[2], d = state[3];
+        auto e = state[4], f = state[5], g = state[6], h = state[7];
+        for (size_t i = 0; i < 64; ++i)
+        {
+          const auto s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+          const auto ch = (e & f) ^ (~e & g);
+          const auto t1 = h + s1 + ch + K[i] + w[i];
+          const auto s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+          const auto maj = (a & b) ^ (a & c) ^ (b & c);
+          const auto t2 = s0 + maj;
+          h = g;
+          g = f;
+          f = e;
+          e = d + t1;
+          d = c;
+          c = b;
+          b = a;
+          a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+      }
+    }
+
+    vector<uint8_t> sha256(ByteView input)
+    {
+      static const auto compress = select_compress();
+
+      uint32_t state[8] = {0x6a09e667,
+                           0xbb67ae85,
+                           0x3c6ef372,
+                           0xa54ff53a,
+                           0x510e527f,
+                           0x9b05688c,
+                           0x1f83d9ab,
+                           0x5be0cd19};
+
+      const auto full_blocks = input.size() / 64;
+      compress(state, input.data(), full_blocks);
+
+      // Final one or two blocks: remaining bytes, 0x80, zeroes, then the
+      // bit length as a big-endian 64-bit integer
+      uint8_t tail[128] = {};
+      const auto rem = input.size() - full_blocks * 64;
+      if (rem > 0)
+        memcpy(tail, input.data() + full_blocks * 64, rem);
+      tail[rem] = 0x80;
+      const size_t tail_len = rem < 56 ? 64 : 128;
+      const uint64_t bits = uint64_t(input.size()) * 8;
+      for (size_t i = 0; i < 8; ++i)
+        tail[tail_len - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+      compress(state, tail, tail_len / 64);
+
+      vector<uint8_t> output(32);
+      for (size_t i = 0; i < 8; ++i)
+      {
+        output[4 * i] = static_cast<uint8_t>(state[i] >> 24);
+        output[4 * i + 1] = static_cast<uint8_t>(state[i] >> 16);
+        output[4 * i + 2] = static_cast<uint8_t>(state[i] >> 8);
+        output[4 * i + 3] = static_cast<uint8_t>(state[i]);
+      }
+      return output;
+    }
+  } // namespace precompiled
+} // namespace eevm
@@ -0,0 +1,24 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace eevm
+{
+  namespace precompiled
+  {
+    /// Applies the SHA-256 compression function to each of the n 64-byte
+    /// blocks at data, updating state
+    using Sha256Compress =
+      void (*)(uint32_t* state, const uint8_t* data, size_t n);
+
+    void sha256_compress_generic(
+      uint32_t* state, const uint8_t* data, size_t n);
+
+    /// Uses the x86 SHA extensions, which the host must support
+    void sha256_compress_shani(uint32_t* state, const uint8_t* data, size_t n);
+  } // namespace precompiled
+} // namespace eevm
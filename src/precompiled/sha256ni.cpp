@@ -0,0 +1,92 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// Compiled with -msha -msse4.1. As with the Keccak SIMD kernels, this must not
+// include any headers which define inline library code.
+#include "sha256.h"
+
+#include <immintrin.h>
+
+namespace eevm
+{
+  namespace precompiled
+  {
+    namespace
+    {
+      alignas(16) constexpr uint32_t K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+        0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+        0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+        0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+        0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+        0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+        0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+        0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+        0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+    } // namespace
+
+    void sha256_compress_shani(uint32_t* state, const uint8_t* data, size_t n)
+    {
+      const __m128i byteswap =
+        _mm_set_epi64x(0x0c0d0e0f08090a0bull, 0x0405060700010203ull);
+
+      // The SHA instructions want the state as ABEF and CDGH
+      __m128i tmp = _mm_loadu_si128((const __m128i*)&state[0]);
+      __m128i state1 = _mm_loadu_si128((const __m128i*)&state[4]);
+      tmp = _mm_shuffle_epi32(tmp, 0xb1); // CDAB
+      state1 = _mm_shuffle_epi32(state1, 0x1b); // EFGH
+      __m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+      state1 = _mm_blend_epi16(state1, tmp, 0xf0); // CDGH
+
+      for (; n > 0; --n, data += 64)
+      {
+        const __m128i abef = state0;
+        const __m128i cdgh = state1;
+
+        // Four rounds per iteration, with the message schedule for later
+        // rounds computed in a rotating window of four registers
+        __m128i msgs[4];
+        for (int i = 0; i < 16; ++i)
+        {
+          __m128i& cur = msgs[i % 4];
+          if (i < 4)
+            cur = _mm_shuffle_epi8(
+              _mm_loadu_si128((const __m128i*)(data + 16 * i)), byteswap);
+
+          __m128i msg =
+            _mm_add_epi32(cur, _mm_load_si128((const __m128i*)&K[4 * i]));
+          state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+
+          if (i >= 3 && i <= 14)
+          {
+            __m128i& next = msgs[(i + 1) % 4];
+            next =
+              _mm_add_epi32(next, _mm_alignr_epi8(cur, msgs[(i + 3) % 4], 4));
+            next = _mm_sha256msg2_epu32(next, cur);
+          }
+
+          msg = _mm_shuffle_epi32(msg, 0x0e);
+          state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+          if (i >= 1 && i <= 12)
+          {
+            __m128i& prev = msgs[(i + 3) % 4];
+            prev = _mm_sha256msg1_epu32(prev, cur);
+          }
+        }
+
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+      }
+
+      tmp = _mm_shuffle_epi32(state0, 0x1b); // FEBA
+      state1 = _mm_shuffle_epi32(state1, 0xb1); // DCHG
+      state0 = _mm_blend_epi16(tmp, state1, 0xf0); // DCBA
+      state1 = _mm_alignr_epi8(state1, tmp, 8); // ABEF
+      _mm_storeu_si128((__m128i*)&state[0], state0);
+      _mm_storeu_si128((__m128i*)&state[4], state1);
+    }
+  } // namespace precompiled
+} // namespace eevm
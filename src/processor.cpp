@@ -5,18 +5,25 @@
 
 #include "eEVM/bigint.h"
 #include "eEVM/exception.h"
+#include "eEVM/memory.h"
 #include "eEVM/opcode.h"
+#include "eEVM/opcodeinfo.h"
 #include "eEVM/stack.h"
 #include "eEVM/util.h"
+#include "modarith.h"
 
 #include <algorithm>
+#include <array>
 #include <exception>
 #include <functional>
 #include <limits>
+#include <list>
+#include <map>
 #include <memory>
+#include <optional>
 #include <set>
-#include <sstream>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 
 using namespace std;
@@ -35,35 +42,579 @@ namespace eevm
     return (v >> 255) ? -1 : 1;
   }
 
+  /// Whether v fits in 64 bits. Most words are small (offsets, lengths,
+  /// counters, booleans), so handlers check this to skip 256-bit arithmetic.
+  inline bool is_small(const uint256_t& v)
+  {
+    return (v.lo.hi | v.hi.lo | v.hi.hi) == 0;
+  }
+
+  inline bool both_small(const uint256_t& x, const uint256_t& y)
+  {
+    return (x.lo.hi | x.hi.lo | x.hi.hi | y.lo.hi | y.hi.lo | y.hi.hi) == 0;
+  }
+
+  /**
+   * A common sequence of instructions within a basic block, executed by a
+   * single dispatch
+   */
+  struct Superinstruction
+  {
+    enum class Kind : uint8_t
+    {
+      push_jump, // PUSHn x; JUMP
+      push_jumpi, // PUSHn x; JUMPI
+      push_add, // PUSHn x; ADD
+      dup_push_and, // DUPn; PUSHm x; AND
+      swap_pop, // SWAPn; POP
+      push, // PUSHn x, pre-decoded (cached programs only)
+      // DUP1; PUSHn s; EQ; PUSHm d; JUMPI, repeated (cached programs only)
+      selector_switch
+    };
+
+    Kind kind;
+    /// bytes of code covered by the sequence (but for selector_switch, whose
+    /// table holds its end)
+    uint8_t length;
+    /// depth of DUPn or SWAPn
+    uint8_t n = 0;
+    /// whether imm is a valid jump destination, resolved statically
+    bool static_dest = false;
+    /// index of the Program's SelectorTable for selector_switch
+    uint32_t table = 0;
+    /// pushed immediate
+    uint256_t imm = 0;
+  };
+
+  /**
+   * A Solidity function dispatcher: a chain of comparisons of the selector
+   * on top of the stack with each of the contract's functions, jumping to
+   * the first which matches. Running the chain leaves the stack as it was,
+   * so it is replaced by a single lookup, which falls through to end if no
+   * selector matches.
+   */
+  struct SelectorTable
+  {
+    /// destination of each selector, from its first comparison in the chain
+    unordered_map<uint32_t, uint64_t> dests;
+    /// pc following the chain
+    uint64_t end = 0;
+
+    const uint64_t* find(const uint256_t& selector) const
+    {
+      if (selector > numeric_limits<uint32_t>::max())
+        return nullptr;
+      const auto it = dests.find(static_cast<uint32_t>(selector));
+      return it == dests.end() ? nullptr : &it->second;
+    }
+  };
+
+  /**
+   * Stack requirements of a basic block: a straight run of instructions,
+   * entered only at its start, which ends before a jump destination or after
+   * JUMP or a terminator. JUMPI does not end a block, as it either leaves it
+   * or carries on with the rest of it.
+   */
+  struct BasicBlock
+  {
+    /// height the stack needs on entry, so that no instruction underflows
+    uint64_t min_height = 0;
+    /// greatest height the stack reaches above its height on entry
+    uint64_t max_growth = 0;
+    /// pc following the block's last instruction
+    uint64_t end = 0;
+
+    /// whether no instruction of the block can fault on stack bounds, when
+    /// entered with the given height
+    bool fits(uint64_t height) const
+    {
+      return height >= min_height && height + max_growth <= Stack::MAX_SIZE;
+    }
+  };
+
   /**
-   * bytecode program
+   * bytecode program. Programs held in the analysis cache, and so reused, also
+   * pre-decode the immediate of every PUSH.
    */
   class Program
   {
   public:
     const vector<uint8_t> code;
     const set<uint64_t> jump_dests;
+    /// implementation to which the code forwards every call, if it is an
+    /// EIP-1167 minimal proxy
+    const optional<Address> clone_of;
 
-    Program(vector<uint8_t>&& c) : code(c), jump_dests(compute_jump_dests(code))
-    {}
+  private:
+    vector<Superinstruction> superinstructions;
+    /// index + 1 into superinstructions of the sequence starting at each pc,
+    /// or 0 if there is none
+    vector<uint32_t> superinstruction_index;
+    vector<SelectorTable> selector_tables;
+    vector<BasicBlock> blocks;
+    /// index + 1 into blocks of the block starting at each pc, or 0 if none
+    /// does
+    vector<uint32_t> block_index;
+
+  public:
+    Program(vector<uint8_t>&& c, bool cached = false) :
+      code(move(c)),
+      jump_dests(compute_jump_dests(code)),
+      clone_of(find_clone_target(code))
+    {
+      fuse(cached);
+      find_blocks();
+    }
+
+    const Superinstruction* superinstruction_at(uint64_t pc) const
+    {
+      const auto i = superinstruction_index[pc];
+      return i ? &superinstructions[i - 1] : nullptr;
+    }
+
+    const SelectorTable& selector_table(uint32_t i) const
+    {
+      return selector_tables[i];
+    }
+
+    const BasicBlock* block_at(uint64_t pc) const
+    {
+      const auto i = block_index[pc];
+      return i ? &blocks[i - 1] : nullptr;
+    }
 
   private:
+    static optional<Address> find_clone_target(const vector<uint8_t>& code)
+    {
+      // EIP-1167 runtime code, either side of the implementation's address
+      static constexpr uint8_t prefix[] = {
+        0x36, 0x3d, 0x3d, 0x37, 0x3d, 0x3d, 0x3d, 0x36, 0x3d, 0x73};
+      static constexpr uint8_t suffix[] = {0x5a,
+                                           0xf4,
+                                           0x3d,
+                                           0x82,
+                                           0x80,
+                                           0x3e,
+                                           0x90,
+                                           0x3d,
+                                           0x91,
+                                           0x60,
+                                           0x2b,
+                                           0x57,
+                                           0xfd,
+                                           0x5b,
+                                           0xf3};
+      constexpr auto address_size = 20u;
+
+      if (code.size() != sizeof(prefix) + address_size + sizeof(suffix))
+        return nullopt;
+      const auto address = code.data() + sizeof(prefix);
+      if (
+        !equal(begin(prefix), end(prefix), code.data()) ||
+        !equal(begin(suffix), end(suffix), address + address_size))
+        return nullopt;
+      return from_big_endian(address, address_size);
+    }
+
     set<uint64_t> compute_jump_dests(const vector<uint8_t>& code)
     {
       set<uint64_t> dests;
       for (uint64_t i = 0; i < code.size(); i++)
       {
         const auto op = code[i];
-        if (op >= PUSH1 && op <= PUSH32)
-        {
-          const uint8_t immediate_bytes = op - static_cast<uint8_t>(PUSH1) + 1;
-          i += immediate_bytes;
-        }
-        else if (op == JUMPDEST)
+        if (op == JUMPDEST)
           dests.insert(i);
+        else
+          i += immediate_bytes(op);
       }
       return dests;
     }
+
+    static uint8_t immediate_bytes(uint8_t op)
+    {
+      return op_info(op).immediate_bytes;
+    }
+
+    /// Finds sequences which can be executed as superinstructions. Only the
+    /// first instruction of each may be a jump destination, as none of the
+    /// fused opcodes following it is JUMPDEST.
+    void fuse(bool cached)
+    {
+      superinstruction_index.assign(code.size(), 0);
+
+      // Opcode at pc, or STOP beyond the end of the code
+      const auto op_at = [this](uint64_t pc) -> uint8_t {
+        return pc < code.size() ? code[pc] : STOP;
+      };
+      // Whether the PUSH at pc has all of its immediate bytes
+      const auto complete_push = [this](uint64_t pc) {
+        return pc + immediate_bytes(code[pc]) < code.size();
+      };
+      const auto read_imm = [this](uint64_t pc) {
+        uint256_t imm = 0;
+        for (uint8_t i = 1; i <= immediate_bytes(code[pc]); i++)
+          imm = (imm << 8) | code[pc + i];
+        return imm;
+      };
+      // Length of the dispatcher entry DUP1; PUSHn s; EQ; PUSHm d; JUMPI at
+      // pc, or 0 if there is none. Only selectors of up to 4 bytes, and
+      // valid destinations, are matched.
+      const auto dispatcher_entry =
+        [&](uint64_t pc, uint32_t& selector, uint64_t& dest) -> uint64_t {
+        if (op_at(pc) != DUP1)
+          return 0;
+        const auto sel_pc = pc + 1;
+        const auto sel_bytes = immediate_bytes(op_at(sel_pc));
+        if (!sel_bytes || sel_bytes > 4 || !complete_push(sel_pc))
+          return 0;
+        const auto eq_pc = sel_pc + 1 + sel_bytes;
+        if (op_at(eq_pc) != EQ)
+          return 0;
+        const auto dest_pc = eq_pc + 1;
+        const auto dest_bytes = immediate_bytes(op_at(dest_pc));
+        if (!dest_bytes || dest_bytes > 8 || !complete_push(dest_pc))
+          return 0;
+        const auto jumpi_pc = dest_pc + 1 + dest_bytes;
+        if (op_at(jumpi_pc) != JUMPI)
+          return 0;
+
+        dest = static_cast<uint64_t>(read_imm(dest_pc));
+        if (jump_dests.find(dest) == jump_dests.end())
+          return 0;
+        selector = static_cast<uint32_t>(read_imm(sel_pc));
+        return jumpi_pc + 1 - pc;
+      };
+
+      uint64_t next_pc = 0;
+      while (next_pc < code.size())
+      {
+        const auto pc = next_pc;
+        const auto op = code[pc];
+        next_pc += 1 + immediate_bytes(op);
+        Superinstruction si{};
+
+        if (cached && op == DUP1)
+        {
+          // A chain of dispatcher entries is fused whole. The entries after
+          // the first are only reached through it, so are not fused
+          // themselves.
+          SelectorTable table;
+          size_t entries = 0;
+          uint64_t end = pc;
+          uint32_t selector;
+          uint64_t dest;
+          while (const auto len = dispatcher_entry(end, selector, dest))
+          {
+            table.dests.emplace(selector, dest);
+            end += len;
+            ++entries;
+          }
+
+          if (entries >= 2)
+          {
+            table.end = end;
+            selector_tables.push_back(move(table));
+            si.kind = Superinstruction::Kind::selector_switch;
+            si.table = static_cast<uint32_t>(selector_tables.size() - 1);
+            next_pc = end;
+            superinstructions.push_back(si);
+            superinstruction_index[pc] =
+              static_cast<uint32_t>(superinstructions.size());
+            continue;
+          }
+        }
+
+        if (immediate_bytes(op) && complete_push(pc))
+        {
+          const uint8_t push_len = 1 + immediate_bytes(op);
+          const auto next = op_at(pc + push_len);
+          si.imm = read_imm(pc);
+          si.length = push_len + 1;
+          // Jump targets which do not fit in 64 bits fail in pop64, so are
+          // left to the unfused handlers
+          if (
+            (next == JUMP || next == JUMPI) &&
+            si.imm <= numeric_limits<uint64_t>::max())
+          {
+            si.kind = next == JUMP ? Superinstruction::Kind::push_jump :
+                                     Superinstruction::Kind::push_jumpi;
+            const auto dest = static_cast<uint64_t>(si.imm);
+            si.static_dest = jump_dests.find(dest) != jump_dests.end();
+          }
+          else if (next == ADD)
+            si.kind = Superinstruction::Kind::push_add;
+          else if (cached)
+          {
+            si.kind = Superinstruction::Kind::push;
+            si.length = push_len;
+          }
+          else
+            continue;
+        }
+        else if (op >= DUP1 && op <= DUP16)
+        {
+          const auto push = op_at(pc + 1);
+          if (!immediate_bytes(push) || !complete_push(pc + 1))
+            continue;
+          const uint8_t push_len = 1 + immediate_bytes(push);
+          if (op_at(pc + 1 + push_len) != AND)
+            continue;
+          si.kind = Superinstruction::Kind::dup_push_and;
+          si.n = op - DUP1;
+          si.imm = read_imm(pc + 1);
+          si.length = push_len + 2;
+        }
+        else if (op >= SWAP1 && op <= SWAP16 && op_at(pc + 1) == POP)
+        {
+          si.kind = Superinstruction::Kind::swap_pop;
+          si.n = op - SWAP1 + 1;
+          si.length = 2;
+        }
+        else
+          continue;
+
+        superinstructions.push_back(si);
+        superinstruction_index[pc] =
+          static_cast<uint32_t>(superinstructions.size());
+      }
+    }
+
+    /// Splits the code into basic blocks, and finds the stack height each
+    /// needs and the growth it makes, from the opcodes' stack effects
+    void find_blocks()
+    {
+      block_index.assign(code.size(), 0);
+
+      // height of the stack relative to its height on entering the block
+      int64_t height = 0;
+      bool open = false;
+      for (uint64_t pc = 0; pc < code.size();)
+      {
+        const auto op = code[pc];
+        const auto& info = op_info(op);
+        if (!open || op == JUMPDEST)
+        {
+          blocks.emplace_back();
+          block_index[pc] = static_cast<uint32_t>(blocks.size());
+          height = 0;
+          open = true;
+        }
+
+        auto& b = blocks.back();
+        const auto need = info.stack_in - height;
+        if (need > 0)
+          b.min_height = max(b.min_height, static_cast<uint64_t>(need));
+        height += info.stack_out - info.stack_in;
+        if (height > 0)
+          b.max_growth = max(b.max_growth, static_cast<uint64_t>(height));
+
+        pc = min<uint64_t>(pc + 1 + immediate_bytes(op), code.size());
+        b.end = pc;
+        if (op == JUMP || info.has(OpInfo::terminator))
+          open = false;
+      }
+    }
+  };
+
+  /**
+   * The analysis cache. Once a piece of code has been run often enough, it is
+   * analysed once and the resulting Program is shared by every later run,
+   * rather than being re-analysed for each call. Programs are still
+   * interpreted; no native code is generated. Code is found by its hash, so
+   * every account holding the same code (such as clones of one contract)
+   * shares one cached program, and a cached program is reached without
+   * copying the account's code.
+   *
+   * That needs the hash on every call, so is only done for accounts which
+   * hold it (see Account::holds_code_hash). Code of other accounts is
+   * counted by address, and hashed only once, when it is to be cached.
+   * Later calls find the cached program through the address, and compare
+   * its code with the account's to notice if the code there has changed.
+   *
+   * At most MAX_CACHED_PROGRAMS are held, evicting the least recently used
+   * to make room for another. Programs still running when evicted are kept
+   * alive by the frames running them.
+   */
+  class ProgramCache
+  {
+    struct Cached
+    {
+      shared_ptr<const Program> program;
+      /// position in lru
+      list<uint256_t>::iterator used;
+    };
+
+    /// by hash of the code
+    map<uint256_t, Cached> cached;
+    /// hashes of cached programs, most recently used first
+    list<uint256_t> lru;
+    /// runs of code not yet cached, by hash of the code
+    map<uint256_t, size_t> counts;
+    /// as counts, for accounts which do not hold their code's hash
+    map<Address, size_t> address_counts;
+    /// hash of the code cached for accounts which do not hold it
+    map<Address, uint256_t> address_hashes;
+    uint64_t fills = 0;
+
+    /// Counts a run of code not yet cached, returning whether it has now
+    /// run often enough to be cached
+    template <typename Key>
+    bool count(map<Key, size_t>& counters, const Key& key)
+    {
+      if (threshold == 0)
+        return true;
+      if (threshold == Processor::NEVER_CACHE)
+        return false;
+
+      auto it = counters.find(key);
+      if (it == counters.end())
+      {
+        // Rather than track which counters are cold, drop them all. Code
+        // which is still running soon counts up again, while code which has
+        // stopped no longer holds an entry.
+        if (counters.size() >= MAX_COUNTED)
+          counters.clear();
+        it = counters.emplace(key, 0).first;
+      }
+
+      if (it->second++ < threshold)
+        return false;
+      counters.erase(it);
+      return true;
+    }
+
+    /// The cached program for the given hash, marked as most recently
+    /// used, or nullptr if there is none
+    shared_ptr<const Program> find(const uint256_t& hash)
+    {
+      const auto it = cached.find(hash);
+      if (it == cached.end())
+        return nullptr;
+      lru.splice(lru.begin(), lru, it->second.used);
+      return it->second.program;
+    }
+
+    shared_ptr<const Program> fill(const uint256_t& hash, Code&& code)
+    {
+      if (cached.size() >= Processor::MAX_CACHED_PROGRAMS)
+      {
+        cached.erase(lru.back());
+        lru.pop_back();
+      }
+
+      lru.push_front(hash);
+      auto program = make_shared<const Program>(move(code), true);
+      cached.emplace(hash, Cached{program, lru.begin()});
+      ++fills;
+      return program;
+    }
+
+    shared_ptr<const Program> load_by_address(const Account& acc)
+    {
+      const auto addr = acc.get_address();
+      auto code = acc.get_code();
+
+      const auto known = address_hashes.find(addr);
+      if (known != address_hashes.end())
+      {
+        const auto program = find(known->second);
+        if (program && program->code == code)
+          return program;
+        address_hashes.erase(known);
+      }
+
+      if (!count(address_counts, addr))
+        return make_shared<const Program>(move(code));
+
+      const auto hash = acc.get_code_hash();
+      if (address_hashes.size() >= MAX_COUNTED)
+        address_hashes.clear();
+      address_hashes.emplace(addr, hash);
+      if (auto program = find(hash))
+        return program;
+      return fill(hash, move(code));
+    }
+
+  public:
+    /// Bound on the number of counters held for code not yet cached, and on
+    /// the number of addresses whose cached code's hash is held
+    static constexpr size_t MAX_COUNTED = 4096;
+
+    size_t threshold;
+
+    ProgramCache(size_t threshold) : threshold(threshold) {}
+
+    shared_ptr<const Program> load(const Account& acc)
+    {
+      if (!acc.holds_code_hash())
+        return load_by_address(acc);
+
+      const auto hash = acc.get_code_hash();
+      if (auto program = find(hash))
+        return program;
+
+      if (count(counts, hash))
+        return fill(hash, acc.get_code());
+      return make_shared<const Program>(acc.get_code());
+    }
+
+    size_t size() const
+    {
+      return cached.size();
+    }
+
+    uint64_t num_fills() const
+    {
+      return fills;
+    }
+  };
+
+  /**
+   * Output of the most recent call or create. A frame which returns hands
+   * over its whole memory, of which the output is a region, so that the
+   * output is never copied out of the frame which produced it.
+   */
+  class ReturnData
+  {
+  private:
+    /// memory of the frame which produced the output
+    Memory mem;
+    uint64_t offset = 0;
+    uint64_t len = 0;
+    /// output retained from a native contract, which has no memory of its own
+    vector<uint8_t> native;
+
+  public:
+    ReturnData() = default;
+    ReturnData(Memory&& mem, uint64_t offset, uint64_t size) :
+      mem(move(mem)),
+      offset(offset),
+      len(size)
+    {}
+
+    ByteView view() const
+    {
+      if (!native.empty())
+        return native;
+      return {mem.data() + offset, len};
+    }
+
+    uint64_t size() const
+    {
+      return view().size();
+    }
+
+    void clear()
+    {
+      *this = ReturnData();
+    }
+
+    /// Clears, and returns the buffer in which to retain native output
+    vector<uint8_t>& retain_native()
+    {
+      clear();
+      return native;
+    }
   };
 
   /**
@@ -78,31 +629,57 @@ namespace eevm
     using PcType = decltype(pc);
 
   public:
-    using ReturnHandler = function<void(vector<uint8_t>)>;
+    using ReturnHandler = function<void(ReturnData&&)>;
+    using RevertHandler = function<void(ReturnData&&)>;
     using HaltHandler = function<void()>;
     using ExceptionHandler = function<void(const Exception&)>;
 
-    vector<uint8_t> mem;
+    Memory mem;
     Stack s;
+    /// output of the most recent call or create made from this context
+    ReturnData return_data;
+    /// region of memory receiving the output of the call in progress. Held
+    /// here, rather than captured by the callee's handlers, so that those
+    /// captures fit within std::function's inline storage.
+    uint64_t out_offset = 0;
+    uint64_t out_size = 0;
 
     AccountState as;
     Account& acc;
     Storage& st;
     const Address caller;
-    const vector<uint8_t> input;
+    /// view of the caller's memory (or of the transaction's input), which
+    /// does not change while this context runs
+    const ByteView input;
     const uint256_t call_value;
-    const Program prog;
+    /// whether state modifications are forbidden (within a STATICCALL)
+    const bool is_static;
+    /// call depth of this context, counting the frames of any proxies run in
+    /// its place (see push_context)
+    const uint16_t depth;
+    const shared_ptr<const Program> prog;
+    /// end of the basic block being run, if the stack met its requirements on
+    /// entry. Instructions before it need no checks of stack bounds.
+    uint64_t safe_until = 0;
+    /// prog's code, held directly so that fetching an opcode is a single
+    /// load from the context
+    const uint8_t* const code;
+    const uint64_t code_size;
     ReturnHandler rh;
+    RevertHandler rvh;
     HaltHandler hh;
     ExceptionHandler eh;
 
     Context(
       const Address& caller,
       AccountState as,
-      vector<uint8_t>&& input,
+      ByteView input,
       const uint256_t& call_value,
-      Program&& prog,
+      bool is_static,
+      uint16_t depth,
+      shared_ptr<const Program>&& prog,
       ReturnHandler&& rh,
+      RevertHandler&& rvh,
       HaltHandler&& hh,
       ExceptionHandler&& eh) :
       as(as),
@@ -111,10 +688,15 @@ namespace eevm
       caller(caller),
       input(input),
       call_value(call_value),
-      prog(prog),
-      rh(rh),
-      hh(hh),
-      eh(eh)
+      is_static(is_static),
+      depth(depth),
+      prog(move(prog)),
+      code(this->prog->code.data()),
+      code_size(this->prog->code.size()),
+      rh(move(rh)),
+      rvh(move(rvh)),
+      hh(move(hh)),
+      eh(move(eh))
     {}
 
     /// increment the pc if it wasn't changed before
@@ -137,20 +719,28 @@ namespace eevm
       pc_changed = true;
     }
 
+    /// set the pc to a jump destination, leaving the current basic block
+    void jump(const PcType dest)
+    {
+      set_pc(dest);
+      safe_until = 0;
+    }
+
     bool pc_valid() const
     {
-      return pc < prog.code.size();
+      return pc < code_size;
     }
 
     auto get_used_mem() const
     {
-      return (mem.size() + Consts::WORD_SIZE - 1) / Consts::WORD_SIZE;
+      return mem.words();
     }
   };
 
   /**
-   * implementation of the VM
+   * implementation of the VM, specialised for the instruction set of fork F
    */
+  template <Fork F>
   class _Processor
   {
   private:
@@ -160,6 +750,16 @@ namespace eevm
     Transaction& tx;
     /// pointer to trace object (for debugging)
     Trace* const tr;
+    /// pointer to cache of SHA3 results (optional)
+    Sha3Cache* const sha3_cache;
+    /// native contracts, which take precedence over code at their address
+    const NativeContracts& natives;
+    /// analysed programs, shared between runs
+    ProgramCache& programs;
+    /// reducer for the most recent MULMOD modulus
+    optional<modarith::Reducer> reducer;
+    /// fault raised by the current instruction without throwing
+    optional<Exception> fault;
     /// the stack of contexts (one per nested call)
     vector<unique_ptr<Context>> ctxts;
     /// pointer to the current context
@@ -168,43 +768,62 @@ namespace eevm
     using ET = Exception::Type;
 
   public:
-    _Processor(GlobalState& gs, Transaction& tx, Trace* tr) :
+    _Processor(
+      GlobalState& gs,
+      Transaction& tx,
+      Trace* tr,
+      Sha3Cache* sha3_cache,
+      const NativeContracts& natives,
+      ProgramCache& programs) :
       gs(gs),
       tx(tx),
-      tr(tr)
+      tr(tr),
+      sha3_cache(sha3_cache),
+      natives(natives),
+      programs(programs)
     {}
 
     ExecResult run(
       const Address& caller,
       AccountState callee,
-      vector<uint8_t> input, // Take a copy here, then move it into context
+      ByteView input, // outlives the run
       const uint256_t& call_value)
     {
       // create the first context
       ExecResult result;
-      auto rh = [&result](vector<uint8_t> output_) {
+      auto rh = [&result](ReturnData&& output_) {
+        const auto output = output_.view();
         result.er = ExitReason::returned;
-        result.output = move(output_);
+        result.output.assign(output.begin(), output.end());
+      };
+      auto rvh = [&result](ReturnData&& output_) {
+        const auto output = output_.view();
+        result.er = ExitReason::reverted;
+        result.output.assign(output.begin(), output.end());
       };
       auto hh = [&result]() { result.er = ExitReason::halted; };
-      auto eh = [&result](const Exception& ex_) {
+      auto eh = [this, &result](const Exception& ex_) {
         result.er = ExitReason::threw;
         result.ex = ex_.type;
-        result.exmsg = ex_.what();
+        result.expc = ctxt->get_pc();
+        result.exop = get_op();
+        result.error = ex_.get_message();
       };
 
       push_context(
         caller,
         callee,
-        move(input),
-        callee.acc.get_code(),
+        input,
+        programs.load(callee.acc),
         call_value,
+        false,
         rh,
+        rvh,
         hh,
         eh);
 
       // run
-      while (ctxt->get_pc() < ctxt->prog.code.size())
+      while (ctxt->pc_valid())
       {
         try
         {
@@ -216,6 +835,13 @@ namespace eevm
           pop_context();
         }
 
+        if (fault)
+        {
+          ctxt->eh(*fault);
+          fault.reset();
+          pop_context();
+        }
+
         if (!ctxt)
           break;
         ctxt->step();
@@ -236,45 +862,102 @@ namespace eevm
     void push_context(
       const Address& caller,
       AccountState as,
-      vector<uint8_t>&& input,
-      Program&& prog,
+      ByteView input,
+      shared_ptr<const Program>&& prog,
       const uint256_t& call_value,
+      bool is_static,
       Context::ReturnHandler&& rh,
+      Context::RevertHandler&& rvh,
       Context::HaltHandler&& hh,
       Context::ExceptionHandler&& eh)
     {
+      // Every caller pushes a context as the last step of its instruction,
+      // so the fault is raised after the instruction's other effects, as it
+      // was when thrown
       if (get_call_depth() >= Consts::MAX_CALL_DEPTH)
-        throw Exception(
+      {
+        raise(Exception::fault(
           ET::outOfBounds,
-          "Reached max call depth (" + to_string(Consts::MAX_CALL_DEPTH) + ")");
+          "Reached max call depth ({})",
+          Consts::MAX_CALL_DEPTH));
+        return;
+      }
+
+      // A minimal proxy copies its input, DELEGATECALLs its implementation
+      // with it, and then returns or reverts with the output. Its own
+      // instructions have no other effect, so wherever its DELEGATECALL
+      // would be made, the implementation is run in its place. Traces
+      // record the proxy's instructions, so are left to run them. Each
+      // proxy's frame still counts towards the call depth, so that the
+      // implementation meets the depth limit exactly where it would have.
+      size_t depth = get_call_depth();
+      if (F >= Fork::byzantium && !tr)
+      {
+        bool forwarded = false;
+        while (prog->clone_of && depth + 1 < Consts::MAX_CALL_DEPTH)
+        {
+          auto impl = load_clone_target(*prog->clone_of);
+          if (!impl)
+            break;
+          prog = move(impl);
+          ++depth;
+          forwarded = true;
+        }
+
+        // The proxy returns what the implementation returned, and reverts
+        // with what it reverted with. A halt leaves no output to return, and
+        // a fault none to revert with.
+        if (forwarded)
+        {
+          hh = [rh = rh]() { rh({}); };
+          eh = [rvh = rvh](const Exception&) { rvh({}); };
+        }
+      }
 
       auto c = make_unique<Context>(
         caller,
         as,
-        move(input),
+        input,
         call_value,
+        is_static,
+        static_cast<uint16_t>(depth + 1),
         move(prog),
         move(rh),
+        move(rvh),
         move(hh),
         move(eh));
       ctxts.emplace_back(move(c));
       ctxt = ctxts.back().get();
     }
 
+    /// Program of a proxy's implementation, or nullptr if a DELEGATECALL to
+    /// it would not run bytecode
+    shared_ptr<const Program> load_clone_target(const Address& impl)
+    {
+      if (
+        natives.find(impl) ||
+        (impl >= 1 && impl <= NativeContracts::max_standard_address(F)))
+        return nullptr;
+
+      const auto acc = gs.find(impl);
+      if (!acc || acc->get_code_size() == 0)
+        return nullptr;
+      return programs.load(*acc);
+    }
+
     uint16_t get_call_depth() const
     {
-      return static_cast<uint16_t>(ctxts.size());
+      return ctxts.empty() ? 0 : ctxts.back()->depth;
     }
 
     Opcode get_op() const
     {
-      return static_cast<Opcode>(ctxt->prog.code[ctxt->get_pc()]);
+      return static_cast<Opcode>(ctxt->code[ctxt->get_pc()]);
     }
 
-    uint256_t pop_addr(Stack& st)
+    Address pop_addr(Stack& st)
     {
-      static const uint256_t MASK_160 = (uint256_t(1) << 160) - 1;
-      return st.pop() & MASK_160;
+      return st.pop_unchecked();
     }
 
     void pop_context()
@@ -286,32 +969,21 @@ namespace eevm
         ctxt = nullptr;
     }
 
+    /// Copies into a region of dst which has already been checked by
+    /// check_mem_access, padding wherever src runs out
     static void copy_mem_raw(
       const uint64_t offDst,
       const uint64_t offSrc,
       const uint64_t size,
-      vector<uint8_t>& dst,
-      const vector<uint8_t>& src,
+      Memory& dst,
+      ByteView src,
       const uint8_t pad = 0)
     {
       if (!size)
         return;
 
       const auto lastDst = offDst + size;
-      if (lastDst < offDst)
-        throw Exception(
-          ET::outOfBounds,
-          "Integer overflow in copy_mem (" + to_string(lastDst) + " < " +
-            to_string(offDst) + ")");
-
-      if (lastDst > Consts::MAX_MEM_SIZE)
-        throw Exception(
-          ET::outOfBounds,
-          "Memory limit exceeded (" + to_string(lastDst) + " > " +
-            to_string(Consts::MAX_MEM_SIZE) + ")");
-
-      if (lastDst > dst.size())
-        dst.resize(lastDst);
+      dst.expand(lastDst);
 
       const auto lastSrc = offSrc + size;
       const auto endSrc =
@@ -319,7 +991,7 @@ namespace eevm
       uint64_t remaining;
       if (endSrc > offSrc)
       {
-        copy(src.begin() + offSrc, src.begin() + endSrc, dst.begin() + offDst);
+        copy(src.begin() + offSrc, src.begin() + endSrc, dst.data() + offDst);
         remaining = lastSrc - endSrc;
       }
       else
@@ -328,51 +1000,77 @@ namespace eevm
       }
 
       // if there are more bytes to copy than available, add padding
-      fill(dst.begin() + lastDst - remaining, dst.begin() + lastDst, pad);
+      fill(dst.data() + lastDst - remaining, dst.data() + lastDst, pad);
     }
 
-    void copy_mem(
-      vector<uint8_t>& dst, const vector<uint8_t>& src, const uint8_t pad)
+    void copy_mem(Memory& dst, ByteView src, const uint8_t pad)
     {
-      const auto offDst = ctxt->s.pop64();
-      const auto offSrc = ctxt->s.pop64();
-      const auto size = ctxt->s.pop64();
+      const auto offDst = pop64();
+      const auto offSrc = pop64();
+      const auto size = pop64();
+      if (fault)
+        return;
 
+      // Empty copies never fault, wherever they are
+      if (size && !check_mem_access(offDst, size))
+        return;
       copy_mem_raw(offDst, offSrc, size, dst, src, pad);
     }
 
-    void prepare_mem_access(const uint64_t offset, const uint64_t size)
+    /// Checks that a region of memory may be accessed, raising a fault if
+    /// not. Returns whether it may.
+    bool check_mem_access(const uint64_t offset, const uint64_t size)
     {
       const auto end = offset + size;
       if (end < offset)
-        throw Exception(
+      {
+        raise(Exception::fault(
           ET::outOfBounds,
-          "Integer overflow in memory access (" + to_string(end) + " < " +
-            to_string(offset) + ")");
+          "Integer overflow in memory access ({} < {})",
+          end,
+          offset));
+        return false;
+      }
 
       if (end > Consts::MAX_MEM_SIZE)
-        throw Exception(
+      {
+        raise(Exception::fault(
           ET::outOfBounds,
-          "Memory limit exceeded (" + to_string(end) + " > " +
-            to_string(Consts::MAX_MEM_SIZE) + ")");
+          "Memory limit exceeded ({} > {})",
+          end,
+          Consts::MAX_MEM_SIZE));
+        return false;
+      }
+      return true;
+    }
 
-      if (end > ctxt->mem.size())
-        ctxt->mem.resize(end);
+    /// Checks a region of memory, and expands memory to cover it. Returns
+    /// whether it may be accessed: if not, a fault has been raised, and the
+    /// instruction must return without any further effect.
+    bool prepare_mem_access(const uint64_t offset, const uint64_t size)
+    {
+      if (!check_mem_access(offset, size))
+        return false;
+      ctxt->mem.expand(offset + size);
+      return true;
     }
 
+    /// Copies a region of memory which has already been prepared
     vector<uint8_t> copy_from_mem(const uint64_t offset, const uint64_t size)
     {
-      prepare_mem_access(offset, size);
-      return {ctxt->mem.begin() + offset, ctxt->mem.begin() + offset + size};
+      const auto start = ctxt->mem.data() + offset;
+      return {start, start + size};
     }
 
     void jump_to(const uint64_t newPc)
     {
-      if (ctxt->prog.jump_dests.find(newPc) == ctxt->prog.jump_dests.end())
-        throw Exception(
-          ET::illegalInstruction,
-          to_string(newPc) + " is not a jump destination");
-      ctxt->set_pc(newPc);
+      if (ctxt->prog->jump_dests.find(newPc) == ctxt->prog->jump_dests.end())
+      {
+        raise(Exception::fault(
+          ET::illegalInstruction, "{} is not a jump destination", newPc));
+        return;
+      }
+      ctxt->jump(newPc);
     }
 
     template <
@@ -396,90 +1094,247 @@ namespace eevm
     void dispatch()
     {
       const auto op = get_op();
+      // Stack bounds are checked once, on entering a basic block. If the
+      // stack does not meet the block's requirements, some instruction in it
+      // faults, so each is checked as it runs instead.
+      const auto safe =
+        ctxt->get_pc() < ctxt->safe_until || enter_block(ctxt->get_pc());
+
       if (tr) // TODO: remove if from critical path
         tr->add(ctxt->get_pc(), op, get_call_depth(), ctxt->s);
+      // Traces record every instruction, so sequences are only fused when
+      // not tracing
+      else if (safe)
+      {
+        if (const auto si = ctxt->prog->superinstruction_at(ctxt->get_pc()))
+        {
+          run_superinstruction(*si);
+          return;
+        }
+      }
+
+      // Opcodes which always modify state are rejected within a static call
+      // before they have any effect
+      if (ctxt->is_static && op_info(op).has(OpInfo::writes_state))
+      {
+        raise(static_violation());
+        return;
+      }
+
+      if (!safe && !check_stack(op))
+        return;
 
       switch (op)
       {
         case Opcode::PUSH1:
+          push<1>();
+          break;
         case Opcode::PUSH2:
+          push<2>();
+          break;
         case Opcode::PUSH3:
+          push<3>();
+          break;
         case Opcode::PUSH4:
+          push<4>();
+          break;
         case Opcode::PUSH5:
+          push<5>();
+          break;
         case Opcode::PUSH6:
+          push<6>();
+          break;
         case Opcode::PUSH7:
+          push<7>();
+          break;
         case Opcode::PUSH8:
+          push<8>();
+          break;
         case Opcode::PUSH9:
+          push<9>();
+          break;
         case Opcode::PUSH10:
+          push<10>();
+          break;
         case Opcode::PUSH11:
+          push<11>();
+          break;
         case Opcode::PUSH12:
+          push<12>();
+          break;
         case Opcode::PUSH13:
+          push<13>();
+          break;
         case Opcode::PUSH14:
+          push<14>();
+          break;
         case Opcode::PUSH15:
+          push<15>();
+          break;
         case Opcode::PUSH16:
+          push<16>();
+          break;
         case Opcode::PUSH17:
+          push<17>();
+          break;
         case Opcode::PUSH18:
+          push<18>();
+          break;
         case Opcode::PUSH19:
+          push<19>();
+          break;
         case Opcode::PUSH20:
+          push<20>();
+          break;
         case Opcode::PUSH21:
+          push<21>();
+          break;
         case Opcode::PUSH22:
+          push<22>();
+          break;
         case Opcode::PUSH23:
+          push<23>();
+          break;
         case Opcode::PUSH24:
+          push<24>();
+          break;
         case Opcode::PUSH25:
+          push<25>();
+          break;
         case Opcode::PUSH26:
+          push<26>();
+          break;
         case Opcode::PUSH27:
+          push<27>();
+          break;
         case Opcode::PUSH28:
+          push<28>();
+          break;
         case Opcode::PUSH29:
+          push<29>();
+          break;
         case Opcode::PUSH30:
+          push<30>();
+          break;
         case Opcode::PUSH31:
+          push<31>();
+          break;
         case Opcode::PUSH32:
-          push();
+          push<32>();
           break;
         case Opcode::POP:
           pop();
           break;
         case Opcode::SWAP1:
+          swap<1>();
+          break;
         case Opcode::SWAP2:
+          swap<2>();
+          break;
         case Opcode::SWAP3:
+          swap<3>();
+          break;
         case Opcode::SWAP4:
+          swap<4>();
+          break;
         case Opcode::SWAP5:
+          swap<5>();
+          break;
         case Opcode::SWAP6:
+          swap<6>();
+          break;
         case Opcode::SWAP7:
+          swap<7>();
+          break;
         case Opcode::SWAP8:
+          swap<8>();
+          break;
         case Opcode::SWAP9:
+          swap<9>();
+          break;
         case Opcode::SWAP10:
+          swap<10>();
+          break;
         case Opcode::SWAP11:
+          swap<11>();
+          break;
         case Opcode::SWAP12:
+          swap<12>();
+          break;
         case Opcode::SWAP13:
+          swap<13>();
+          break;
         case Opcode::SWAP14:
+          swap<14>();
+          break;
         case Opcode::SWAP15:
+          swap<15>();
+          break;
         case Opcode::SWAP16:
-          swap();
+          swap<16>();
           break;
         case Opcode::DUP1:
+          dup<1>();
+          break;
         case Opcode::DUP2:
+          dup<2>();
+          break;
         case Opcode::DUP3:
+          dup<3>();
+          break;
         case Opcode::DUP4:
+          dup<4>();
+          break;
         case Opcode::DUP5:
+          dup<5>();
+          break;
         case Opcode::DUP6:
+          dup<6>();
+          break;
         case Opcode::DUP7:
+          dup<7>();
+          break;
         case Opcode::DUP8:
+          dup<8>();
+          break;
         case Opcode::DUP9:
+          dup<9>();
+          break;
         case Opcode::DUP10:
+          dup<10>();
+          break;
         case Opcode::DUP11:
+          dup<11>();
+          break;
         case Opcode::DUP12:
+          dup<12>();
+          break;
         case Opcode::DUP13:
+          dup<13>();
+          break;
         case Opcode::DUP14:
+          dup<14>();
+          break;
         case Opcode::DUP15:
+          dup<15>();
+          break;
         case Opcode::DUP16:
-          dup();
+          dup<16>();
           break;
         case Opcode::LOG0:
+          log<0>();
+          break;
         case Opcode::LOG1:
+          log<1>();
+          break;
         case Opcode::LOG2:
+          log<2>();
+          break;
         case Opcode::LOG3:
+          log<3>();
+          break;
         case Opcode::LOG4:
-          log();
+          log<4>();
           break;
         case Opcode::ADD:
           add();
@@ -547,6 +1402,18 @@ namespace eevm
         case Opcode::BYTE:
           byte();
           break;
+        case Opcode::SHL:
+          if (require_fork<Fork::constantinople>())
+            shl();
+          break;
+        case Opcode::SHR:
+          if (require_fork<Fork::constantinople>())
+            shr();
+          break;
+        case Opcode::SAR:
+          if (require_fork<Fork::constantinople>())
+            sar();
+          break;
         case Opcode::JUMP:
           jump();
           break;
@@ -580,6 +1447,18 @@ namespace eevm
         case Opcode::EXTCODECOPY:
           extcodecopy();
           break;
+        case Opcode::EXTCODEHASH:
+          if (require_fork<Fork::constantinople>())
+            extcodehash();
+          break;
+        case Opcode::RETURNDATASIZE:
+          if (require_fork<Fork::byzantium>())
+            returndatasize();
+          break;
+        case Opcode::RETURNDATACOPY:
+          if (require_fork<Fork::byzantium>())
+            returndatacopy();
+          break;
         case Opcode::SLOAD:
           sload();
           break;
@@ -613,12 +1492,27 @@ namespace eevm
         case Opcode::RETURN:
           return_();
           break;
+        case Opcode::REVERT:
+          if (require_fork<Fork::byzantium>())
+            revert();
+          break;
+        case Opcode::INVALID:
+          invalid();
+          break;
         case Opcode::SELFDESTRUCT:
           selfdestruct();
           break;
         case Opcode::CREATE:
           create();
           break;
+        case Opcode::CREATE2:
+          if (require_fork<Fork::constantinople>())
+            create2();
+          break;
+        case Opcode::STATICCALL:
+          if (require_fork<Fork::byzantium>())
+            call();
+          break;
         case Opcode::CALL:
         case Opcode::CALLCODE:
         case Opcode::DELEGATECALL:
@@ -658,84 +1552,323 @@ namespace eevm
           stop();
           break;
         default:
-          stringstream err;
-          err << fmt::format(
-                   "Unknown/unsupported Opcode: 0x{:02x}", int{get_op()})
-              << endl;
-          err << fmt::format(
-                   " in contract {}",
-                   to_checksum_address(ctxt->as.acc.get_address()))
-              << endl;
-          err << fmt::format(" called by {}", to_checksum_address(ctxt->caller))
-              << endl;
-          err << fmt::format(
-                   " at position {}, call-depth {}",
-                   ctxt->get_pc(),
-                   get_call_depth())
-              << endl;
-          throw Exception(Exception::Type::illegalInstruction, err.str());
+          unsupported_opcode();
       };
     }
 
+    /// Runs a fused sequence, with the same effects (and exceptions) as
+    /// running its instructions one by one. Sequences lie within a basic
+    /// block, so are only run once the block's stack bounds are checked.
+    void run_superinstruction(const Superinstruction& si)
+    {
+      const auto next_pc = ctxt->get_pc() + si.length;
+      switch (si.kind)
+      {
+        case Superinstruction::Kind::push_jump:
+          jump_to_static(si);
+          break;
+        case Superinstruction::Kind::push_jumpi:
+          if (ctxt->s.pop_unchecked())
+            jump_to_static(si);
+          else
+            ctxt->set_pc(next_pc);
+          break;
+        case Superinstruction::Kind::push_add:
+          ctxt->s.push_unchecked(si.imm + ctxt->s.pop_unchecked());
+          ctxt->set_pc(next_pc);
+          break;
+        case Superinstruction::Kind::dup_push_and:
+          ctxt->s.dup_unchecked(si.n);
+          ctxt->s.push_unchecked(ctxt->s.pop_unchecked() & si.imm);
+          ctxt->set_pc(next_pc);
+          break;
+        case Superinstruction::Kind::swap_pop:
+          ctxt->s.swap_unchecked(si.n);
+          ctxt->s.pop_unchecked();
+          ctxt->set_pc(next_pc);
+          break;
+        case Superinstruction::Kind::push:
+          ctxt->s.push_unchecked(si.imm);
+          ctxt->set_pc(next_pc);
+          break;
+        case Superinstruction::Kind::selector_switch:
+        {
+          const auto& table = ctxt->prog->selector_table(si.table);
+          if (const auto dest = table.find(ctxt->s.top_unchecked()))
+            ctxt->jump(*dest);
+          else
+            ctxt->set_pc(table.end);
+          break;
+        }
+      }
+    }
+
+    /// Jumps to a pushed destination, which only needs checking at runtime
+    /// if analysis found it invalid (to throw the usual exception)
+    void jump_to_static(const Superinstruction& si)
+    {
+      const auto dest = static_cast<uint64_t>(si.imm);
+      if (si.static_dest)
+      {
+        ctxt->jump(dest);
+      }
+      else
+      {
+        // The jump faults, so is reported at the JUMP(I) itself rather than
+        // at the start of the sequence
+        ctxt->set_pc(ctxt->get_pc() + si.length - 1);
+        jump_to(dest);
+      }
+    }
+
+    /// Enters the basic block starting at pc, if there is one and the stack
+    /// meets its requirements. Returns whether it did.
+    bool enter_block(uint64_t pc)
+    {
+      const auto b = ctxt->prog->block_at(pc);
+      if (!b || !b->fits(ctxt->s.size()))
+        return false;
+
+      ctxt->safe_until = b->end;
+      return true;
+    }
+
+    /// Checks the stack bounds of a single instruction, raising the fault
+    /// which its handler would otherwise meet. Returns whether it may run.
+    bool check_stack(Opcode op)
+    {
+      // Opcodes from later forks, and PUSHes cut short by the end of the
+      // code, fault before they touch the stack
+      if (F < introduced_in(op))
+        return true;
+
+      const auto& info = op_info(op);
+      const auto size = ctxt->s.size();
+      if (size < info.stack_in)
+      {
+        if (op >= Opcode::DUP1 && op <= Opcode::DUP16)
+          raise(Exception::fault(
+            ET::outOfBounds,
+            "Dup out of range ({} >= {})",
+            info.stack_in - 1,
+            size));
+        else if (op >= Opcode::SWAP1 && op <= Opcode::SWAP16)
+          raise(Exception::fault(
+            ET::outOfBounds,
+            "Swap out of range ({} >= {})",
+            info.stack_in - 1,
+            size));
+        else
+          raise(Exception::fault(ET::outOfBounds, "Stack out of range"));
+        return false;
+      }
+
+      const auto truncated =
+        ctxt->get_pc() + info.immediate_bytes >= ctxt->code_size;
+      if (
+        size - info.stack_in + info.stack_out > Stack::MAX_SIZE && !truncated)
+      {
+        raise(Exception::fault(
+          ET::outOfBounds,
+          "Stack mem exceeded ({} == {})",
+          Stack::MAX_SIZE,
+          Stack::MAX_SIZE));
+        return false;
+      }
+      return true;
+    }
+
+    /// Raises a fault without throwing. The instruction returns as soon as
+    /// it has raised one, and the run loop then handles it as it would a
+    /// thrown fault. Only the first fault an instruction raises is kept.
+    void raise(Exception&& e)
+    {
+      if (!fault)
+        fault.emplace(move(e));
+    }
+
+    /// Pops an operand which must fit in 64 bits, raising a fault if it does
+    /// not. Instructions check for the fault once they have popped their
+    /// operands, before acting on any of them.
+    uint64_t pop64()
+    {
+      const auto val = ctxt->s.pop_unchecked();
+      if (!Stack::fits64(val))
+        raise(Stack::too_large(val));
+      return val.lo.lo;
+    }
+
+    /// An address as three fault operands, for "0x{:08x}{:016x}{:016x}"
+    static array<uint64_t, 3> address_operands(const Address& a)
+    {
+      const uint256_t v = a;
+      return {v.hi.lo, v.lo.hi, v.lo.lo};
+    }
+
+    /// Pays value from the current account, as Account::pay_to, but raising
+    /// a fault rather than throwing one. Returns whether it paid.
+    bool pay(Account& payee, const uint256_t& value)
+    {
+      const auto to = address_operands(payee.get_address());
+      if (value > ctxt->acc.get_balance())
+      {
+        raise(Exception::fault(
+          ET::outOfFunds,
+          "Insufficient funds to pay 0x{:08x}{:016x}{:016x} at position {}, "
+          "call-depth {}",
+          to[0],
+          to[1],
+          to[2],
+          ctxt->get_pc(),
+          get_call_depth()));
+        return false;
+      }
+
+      const auto payee_balance = payee.get_balance();
+      if (payee_balance + value < payee_balance)
+      {
+        raise(Exception::fault(
+          ET::overflow,
+          "Overflow of the balance of 0x{:08x}{:016x}{:016x} at position {}, "
+          "call-depth {}",
+          to[0],
+          to[1],
+          to[2],
+          ctxt->get_pc(),
+          get_call_depth()));
+        return false;
+      }
+
+      ctxt->acc.pay_to(payee, value);
+      return true;
+    }
+
+    void unsupported_opcode()
+    {
+      const auto at = address_operands(ctxt->acc.get_address());
+      raise(Exception::fault(
+        ET::illegalInstruction,
+        "Unknown/unsupported Opcode: 0x{:02x} at position {} of "
+        "0x{:08x}{:016x}{:016x}, call-depth {}",
+        get_op(),
+        ctxt->get_pc(),
+        at[0],
+        at[1],
+        at[2],
+        get_call_depth()));
+    }
+
+    /// Opcodes from later forks are treated as unknown. This is resolved at
+    /// compile time, so costs nothing on forks which support them. Returns
+    /// whether the opcode may run.
+    template <Fork Introduced>
+    bool require_fork()
+    {
+      if constexpr (F < Introduced)
+      {
+        unsupported_opcode();
+        return false;
+      }
+      else
+      {
+        return true;
+      }
+    }
+
+    Exception static_violation()
+    {
+      return Exception::fault(
+        ET::illegalInstruction,
+        "Opcode 0x{:02x} modifies state within a static call",
+        get_op());
+    }
+
+    /// For opcodes which only sometimes modify state (CALL with a value).
+    /// Returns whether the instruction may run.
+    bool require_non_static()
+    {
+      if (ctxt->is_static)
+      {
+        raise(static_violation());
+        return false;
+      }
+      return true;
+    }
+
     //
     // op codes
     //
+    template <uint8_t N>
     void swap()
     {
-      ctxt->s.swap(get_op() - SWAP1 + 1);
+      ctxt->s.swap_unchecked<N>();
     }
 
+    template <uint8_t N>
     void dup()
     {
-      ctxt->s.dup(get_op() - DUP1);
+      ctxt->s.dup_unchecked<N - 1>();
     }
 
     void add()
     {
-      const auto x = ctxt->s.pop();
-      const auto y = ctxt->s.pop();
-      ctxt->s.push(x + y);
+      const auto x = ctxt->s.pop_unchecked();
+      const auto y = ctxt->s.pop_unchecked();
+      if (both_small(x, y))
+        ctxt->s.push_unchecked(uint256_t(intx::uint128(x.lo.lo) + y.lo.lo));
+      else
+        ctxt->s.push_unchecked(x + y);
     }
 
     void sub()
     {
-      const auto x = ctxt->s.pop();
-      const auto y = ctxt->s.pop();
-      ctxt->s.push(x - y);
+      const auto x = ctxt->s.pop_unchecked();
+      const auto y = ctxt->s.pop_unchecked();
+      if (both_small(x, y) && x.lo.lo >= y.lo.lo)
+        ctxt->s.push_unchecked(x.lo.lo - y.lo.lo);
+      else
+        ctxt->s.push_unchecked(x - y);
     }
 
     void mul()
     {
-      const auto x = ctxt->s.pop();
-      const auto y = ctxt->s.pop();
-      ctxt->s.push(x * y);
+      const auto x = ctxt->s.pop_unchecked();
+      const auto y = ctxt->s.pop_unchecked();
+      if (both_small(x, y))
+        ctxt->s.push_unchecked(uint256_t(intx::umul(x.lo.lo, y.lo.lo)));
+      else
+        ctxt->s.push_unchecked(x * y);
     }
 
     void div()
     {
-      const auto x = ctxt->s.pop();
-      const auto y = ctxt->s.pop();
+      const auto x = ctxt->s.pop_unchecked();
+      const auto y = ctxt->s.pop_unchecked();
       if (!y)
       {
-        ctxt->s.push(0);
+        ctxt->s.push_unchecked(0);
+      }
+      else if (both_small(x, y))
+      {
+        ctxt->s.push_unchecked(x.lo.lo / y.lo.lo);
       }
       else
       {
-        ctxt->s.push(x / y);
+        ctxt->s.push_unchecked(x / y);
       }
     }
 
     void sdiv()
     {
-      auto x = ctxt->s.pop();
-      auto y = ctxt->s.pop();
+      auto x = ctxt->s.pop_unchecked();
+      auto y = ctxt->s.pop_unchecked();
       const auto min = (numeric_limits<uint256_t>::max() / 2) + 1;
 
       if (y == 0)
-        ctxt->s.push(0);
+        ctxt->s.push_unchecked(0);
       // special "overflow case" from the yellow paper
       else if (x == min && y == -1)
-        ctxt->s.push(x);
+        ctxt->s.push_unchecked(x);
       else
       {
         const auto signX = get_sign(x);
@@ -748,26 +1881,28 @@ namespace eevm
         auto z = (x / y);
         if (signX != signY)
           z = 0 - z;
-        ctxt->s.push(z);
+        ctxt->s.push_unchecked(z);
       }
     }
 
     void mod()
     {
-      const auto x = ctxt->s.pop();
-      const auto m = ctxt->s.pop();
+      const auto x = ctxt->s.pop_unchecked();
+      const auto m = ctxt->s.pop_unchecked();
       if (!m)
-        ctxt->s.push(0);
+        ctxt->s.push_unchecked(0);
+      else if (both_small(x, m))
+        ctxt->s.push_unchecked(x.lo.lo % m.lo.lo);
       else
-        ctxt->s.push(x % m);
+        ctxt->s.push_unchecked(x % m);
     }
 
     void smod()
     {
-      auto x = ctxt->s.pop();
-      auto m = ctxt->s.pop();
+      auto x = ctxt->s.pop_unchecked();
+      auto m = ctxt->s.pop_unchecked();
       if (m == 0)
-        ctxt->s.push(0);
+        ctxt->s.push_unchecked(0);
       else
       {
         const auto signX = get_sign(x);
@@ -780,56 +1915,54 @@ namespace eevm
         auto z = (x % m);
         if (signX == -1)
           z = 0 - z;
-        ctxt->s.push(z);
+        ctxt->s.push_unchecked(z);
       }
     }
 
     void addmod()
     {
-      const uint512_t x = ctxt->s.pop();
-      const uint512_t y = ctxt->s.pop();
-      const auto m = ctxt->s.pop();
+      const auto x = ctxt->s.pop_unchecked();
+      const auto y = ctxt->s.pop_unchecked();
+      const auto m = ctxt->s.pop_unchecked();
       if (!m)
       {
-        ctxt->s.push(0);
+        ctxt->s.push_unchecked(0);
       }
       else
       {
-        const uint512_t n = (x + y) % m;
-        ctxt->s.push(n.lo);
+        ctxt->s.push_unchecked(modarith::addmod(x, y, m));
       }
     }
 
     void mulmod()
     {
-      const uint512_t x = ctxt->s.pop();
-      const uint512_t y = ctxt->s.pop();
-      const auto m = ctxt->s.pop();
+      const auto x = ctxt->s.pop_unchecked();
+      const auto y = ctxt->s.pop_unchecked();
+      const auto m = ctxt->s.pop_unchecked();
       if (!m)
       {
-        ctxt->s.push(m);
+        ctxt->s.push_unchecked(m);
       }
       else
       {
-        const uint512_t n = (x * y) % m;
-        ctxt->s.push(n.lo);
+        ctxt->s.push_unchecked(modarith::mulmod(x, y, m, reducer));
       }
     }
 
     void exp()
     {
-      const auto b = ctxt->s.pop();
-      const auto e = ctxt->s.pop64();
-      ctxt->s.push(intx::exp(b, uint256_t(e)));
+      const auto b = ctxt->s.pop_unchecked();
+      const auto e = ctxt->s.pop_unchecked();
+      ctxt->s.push_unchecked(modarith::exp(b, e));
     }
 
     void signextend()
     {
-      const auto x = ctxt->s.pop();
-      const auto y = ctxt->s.pop();
+      const auto x = ctxt->s.pop_unchecked();
+      const auto y = ctxt->s.pop_unchecked();
       if (x >= 32)
       {
-        ctxt->s.push(y);
+        ctxt->s.push_unchecked(y);
         return;
       }
       const auto idx = 8 * shrink<uint8_t>(x) + 7;
@@ -837,30 +1970,36 @@ namespace eevm
       constexpr auto zero = uint256_t(0);
       const auto mask = ~zero >> (256 - idx);
       const auto yex = ((sign ? ~zero : zero) << idx) | (y & mask);
-      ctxt->s.push(yex);
+      ctxt->s.push_unchecked(yex);
     }
 
     void lt()
     {
-      const auto x = ctxt->s.pop();
-      const auto y = ctxt->s.pop();
-      ctxt->s.push((x < y) ? 1 : 0);
+      const auto x = ctxt->s.pop_unchecked();
+      const auto y = ctxt->s.pop_unchecked();
+      if (both_small(x, y))
+        ctxt->s.push_unchecked((x.lo.lo < y.lo.lo) ? 1 : 0);
+      else
+        ctxt->s.push_unchecked((x < y) ? 1 : 0);
     }
 
     void gt()
     {
-      const auto x = ctxt->s.pop();
-      const auto y = ctxt->s.pop();
-      ctxt->s.push((x > y) ? 1 : 0);
+      const auto x = ctxt->s.pop_unchecked();
+      const auto y = ctxt->s.pop_unchecked();
+      if (both_small(x, y))
+        ctxt->s.push_unchecked((x.lo.lo > y.lo.lo) ? 1 : 0);
+      else
+        ctxt->s.push_unchecked((x > y) ? 1 : 0);
     }
 
     void slt()
     {
-      const auto x = ctxt->s.pop();
-      const auto y = ctxt->s.pop();
+      const auto x = ctxt->s.pop_unchecked();
+      const auto y = ctxt->s.pop_unchecked();
       if (x == y)
       {
-        ctxt->s.push(0);
+        ctxt->s.push_unchecked(0);
         return;
       }
 
@@ -869,92 +2008,131 @@ namespace eevm
       if (signX != signY)
       {
         if (signX == -1)
-          ctxt->s.push(1);
+          ctxt->s.push_unchecked(1);
         else
-          ctxt->s.push(0);
+          ctxt->s.push_unchecked(0);
       }
       else
       {
-        ctxt->s.push((x < y) ? 1 : 0);
+        ctxt->s.push_unchecked((x < y) ? 1 : 0);
       }
     }
 
     void sgt()
     {
-      ctxt->s.swap(1);
+      ctxt->s.swap_unchecked(1);
       slt();
     }
 
     void eq()
     {
-      const auto x = ctxt->s.pop();
-      const auto y = ctxt->s.pop();
-      if (x == y)
-        ctxt->s.push(1);
+      const auto x = ctxt->s.pop_unchecked();
+      const auto y = ctxt->s.pop_unchecked();
+      if (both_small(x, y))
+        ctxt->s.push_unchecked((x.lo.lo == y.lo.lo) ? 1 : 0);
+      else if (x == y)
+        ctxt->s.push_unchecked(1);
       else
-        ctxt->s.push(0);
+        ctxt->s.push_unchecked(0);
     }
 
     void isZero()
     {
-      const auto x = ctxt->s.pop();
-      if (x == 0)
-        ctxt->s.push(1);
+      const auto x = ctxt->s.pop_unchecked();
+      if (is_small(x) && x.lo.lo == 0)
+        ctxt->s.push_unchecked(1);
       else
-        ctxt->s.push(0);
+        ctxt->s.push_unchecked(0);
     }
 
     void and_()
     {
-      const auto x = ctxt->s.pop();
-      const auto y = ctxt->s.pop();
-      ctxt->s.push(x & y);
+      const auto x = ctxt->s.pop_unchecked();
+      const auto y = ctxt->s.pop_unchecked();
+      ctxt->s.push_unchecked(x & y);
     }
 
     void or_()
     {
-      const auto x = ctxt->s.pop();
-      const auto y = ctxt->s.pop();
-      ctxt->s.push(x | y);
+      const auto x = ctxt->s.pop_unchecked();
+      const auto y = ctxt->s.pop_unchecked();
+      ctxt->s.push_unchecked(x | y);
     }
 
     void xor_()
     {
-      const auto x = ctxt->s.pop();
-      const auto y = ctxt->s.pop();
-      ctxt->s.push(x ^ y);
+      const auto x = ctxt->s.pop_unchecked();
+      const auto y = ctxt->s.pop_unchecked();
+      ctxt->s.push_unchecked(x ^ y);
     }
 
     void not_()
     {
-      const auto x = ctxt->s.pop();
-      ctxt->s.push(~x);
+      const auto x = ctxt->s.pop_unchecked();
+      ctxt->s.push_unchecked(~x);
     }
 
     void byte()
     {
-      const auto idx = ctxt->s.pop();
+      const auto idx = ctxt->s.pop_unchecked();
       if (idx >= 32)
       {
-        ctxt->s.push(0);
+        ctxt->s.push_unchecked(0);
         return;
       }
       const auto shift = 256 - 8 - 8 * shrink<uint8_t>(idx);
       const auto mask = uint256_t(255) << shift;
-      const auto val = ctxt->s.pop();
-      ctxt->s.push((val & mask) >> shift);
+      const auto val = ctxt->s.pop_unchecked();
+      ctxt->s.push_unchecked((val & mask) >> shift);
+    }
+
+    void shl()
+    {
+      const auto shift = ctxt->s.pop_unchecked();
+      const auto x = ctxt->s.pop_unchecked();
+      if (shift >= 256)
+        ctxt->s.push_unchecked(0);
+      else
+        ctxt->s.push_unchecked(x << static_cast<unsigned>(shift));
+    }
+
+    void shr()
+    {
+      const auto shift = ctxt->s.pop_unchecked();
+      const auto x = ctxt->s.pop_unchecked();
+      if (shift >= 256)
+        ctxt->s.push_unchecked(0);
+      else
+        ctxt->s.push_unchecked(x >> static_cast<unsigned>(shift));
+    }
+
+    void sar()
+    {
+      const auto shift = ctxt->s.pop_unchecked();
+      const auto x = ctxt->s.pop_unchecked();
+      const bool negative = get_sign(x) == -1;
+      if (shift >= 256)
+        ctxt->s.push_unchecked(negative ? ~uint256_t(0) : 0);
+      else if (negative)
+        ctxt->s.push_unchecked(~(~x >> static_cast<unsigned>(shift)));
+      else
+        ctxt->s.push_unchecked(x >> static_cast<unsigned>(shift));
     }
 
     void jump()
     {
-      const auto newPc = ctxt->s.pop64();
+      const auto newPc = pop64();
+      if (fault)
+        return;
       jump_to(newPc);
     }
 
     void jumpi()
     {
-      const auto newPc = ctxt->s.pop64();
-      const auto cond = ctxt->s.pop();
+      const auto newPc = pop64();
+      const auto cond = ctxt->s.pop_unchecked();
+      if (fault)
+        return;
       if (cond)
         jump_to(newPc);
     }
@@ -963,48 +2141,57 @@ namespace eevm
 
     void pc()
     {
-      ctxt->s.push(ctxt->get_pc());
+      ctxt->s.push_unchecked(ctxt->get_pc());
     }
 
     void msize()
     {
-      ctxt->s.push(ctxt->get_used_mem() * 32);
+      ctxt->s.push_unchecked(ctxt->get_used_mem() * 32);
     }
 
     void mload()
     {
-      const auto offset = ctxt->s.pop64();
-      prepare_mem_access(offset, Consts::WORD_SIZE);
+      const auto offset = pop64();
+      if (fault)
+        return;
+      if (!prepare_mem_access(offset, Consts::WORD_SIZE))
+        return;
       const auto start = ctxt->mem.data() + offset;
-      ctxt->s.push(from_big_endian(start, Consts::WORD_SIZE));
+      ctxt->s.push_unchecked(from_big_endian(start, Consts::WORD_SIZE));
     }
 
     void mstore()
     {
-      const auto offset = ctxt->s.pop64();
-      const auto word = ctxt->s.pop();
-      prepare_mem_access(offset, Consts::WORD_SIZE);
+      const auto offset = pop64();
+      const auto word = ctxt->s.pop_unchecked();
+      if (fault)
+        return;
+      if (!prepare_mem_access(offset, Consts::WORD_SIZE))
+        return;
       to_big_endian(word, ctxt->mem.data() + offset);
     }
 
     void mstore8()
     {
-      const auto offset = ctxt->s.pop64();
-      const auto b = shrink<uint8_t>(ctxt->s.pop());
-      prepare_mem_access(offset, sizeof(b));
+      const auto offset = pop64();
+      const auto b = shrink<uint8_t>(ctxt->s.pop_unchecked());
+      if (fault)
+        return;
+      if (!prepare_mem_access(offset, sizeof(b)))
+        return;
       ctxt->mem[offset] = b;
     }
 
     void sload()
     {
-      const auto k = ctxt->s.pop();
-      ctxt->s.push(ctxt->st.load(k));
+      const auto k = ctxt->s.pop_unchecked();
+      ctxt->s.push_unchecked(ctxt->st.load(k));
     }
 
     void sstore()
     {
-      const auto k = ctxt->s.pop();
-      const auto v = ctxt->s.pop();
+      const auto k = ctxt->s.pop_unchecked();
+      const auto v = ctxt->s.pop_unchecked();
       if (!v)
         ctxt->st.remove(k);
       else
@@ -1013,28 +2200,81 @@ namespace eevm
 
     void codecopy()
     {
-      copy_mem(ctxt->mem, ctxt->prog.code, Opcode::STOP);
+      copy_mem(ctxt->mem, ctxt->prog->code, Opcode::STOP);
     }
 
+    // Reads of other accounts look them up with find, so that they never
+    // create the accounts they read
+
     void extcodesize()
     {
-      ctxt->s.push(gs.get(pop_addr(ctxt->s)).acc.get_code().size());
+      ctxt->s.push_unchecked(gs.get_code_size(pop_addr(ctxt->s)));
     }
 
     void extcodecopy()
     {
-      copy_mem(
-        ctxt->mem, gs.get(pop_addr(ctxt->s)).acc.get_code(), Opcode::STOP);
+      const auto acc = gs.find(pop_addr(ctxt->s));
+      copy_mem(ctxt->mem, acc ? acc->get_code() : Code{}, Opcode::STOP);
+    }
+
+    void extcodehash()
+    {
+      // Non-existent and empty accounts hash to 0 (EIP-1052)
+      const auto acc = gs.find(pop_addr(ctxt->s));
+      if (
+        !acc ||
+        (acc->get_code_size() == 0 && acc->get_nonce() == 0 &&
+         acc->get_balance() == 0))
+      {
+        ctxt->s.push_unchecked(0);
+        return;
+      }
+
+      ctxt->s.push_unchecked(acc->get_code_hash());
+    }
+
+    void returndatasize()
+    {
+      ctxt->s.push_unchecked(ctxt->return_data.size());
+    }
+
+    void returndatacopy()
+    {
+      const auto offMem = pop64();
+      const auto offData = pop64();
+      const auto size = pop64();
+      if (fault)
+        return;
+
+      // Unlike other copies, reading past the end is an error (EIP-211)
+      const auto end = offData + size;
+      if (end < offData || end > ctxt->return_data.size())
+      {
+        raise(Exception::fault(
+          ET::outOfBounds,
+          "Return data access out of bounds ({} + {} > {})",
+          offData,
+          size,
+          ctxt->return_data.size()));
+        return;
+      }
+
+      if (size && !check_mem_access(offMem, size))
+        return;
+      copy_mem_raw(
+        offMem, offData, size, ctxt->mem, ctxt->return_data.view());
     }
 
     void codesize()
     {
-      ctxt->s.push(ctxt->acc.get_code().size());
+      ctxt->s.push_unchecked(ctxt->acc.get_code().size());
     }
 
     void calldataload()
     {
-      const auto offset = ctxt->s.pop64();
+      const auto offset = pop64();
+      if (fault)
+        return;
       safeAdd(offset, Consts::WORD_SIZE);
       const auto sizeInput = ctxt->input.size();
 
@@ -1052,12 +2292,12 @@ namespace eevm
           break;
         }
       }
-      ctxt->s.push(v);
+      ctxt->s.push_unchecked(v);
     }
 
     void calldatasize()
     {
-      ctxt->s.push(ctxt->input.size());
+      ctxt->s.push_unchecked(ctxt->input.size());
     }
 
     void calldatacopy()
@@ -1067,142 +2307,198 @@ namespace eevm
 
     void address()
     {
-      ctxt->s.push(ctxt->acc.get_address());
+      ctxt->s.push_unchecked(ctxt->acc.get_address());
     }
 
     void balance()
     {
-      decltype(auto) acc = gs.get(pop_addr(ctxt->s)).acc;
-      ctxt->s.push(acc.get_balance());
+      ctxt->s.push_unchecked(gs.get_balance(pop_addr(ctxt->s)));
     }
 
     void origin()
     {
-      ctxt->s.push(tx.origin);
+      ctxt->s.push_unchecked(tx.origin);
     }
 
     void caller()
     {
-      ctxt->s.push(ctxt->caller);
+      ctxt->s.push_unchecked(ctxt->caller);
     }
 
     void callvalue()
     {
-      ctxt->s.push(ctxt->call_value);
+      ctxt->s.push_unchecked(ctxt->call_value);
     }
 
+    /// PUSHn, with the immediate's size known at compile time so that it
+    /// is assembled into words at constant offsets
+    template <uint8_t N>
     void push()
     {
-      const uint8_t bytes = get_op() - PUSH1 + 1;
-      const auto end = ctxt->get_pc() + bytes;
+      const auto end = ctxt->get_pc() + N;
       if (end < ctxt->get_pc())
-        throw Exception(
+      {
+        raise(Exception::fault(
           ET::outOfBounds,
-          "Integer overflow in push (" + to_string(end) + " < " +
-            to_string(ctxt->get_pc()) + ")");
+          "Integer overflow in push ({} < {})",
+          end,
+          ctxt->get_pc()));
+        return;
+      }
 
-      if (end >= ctxt->prog.code.size())
-        throw Exception(
+      if (end >= ctxt->code_size)
+      {
+        raise(Exception::fault(
           ET::outOfBounds,
-          "Push immediate exceeds size of program (" + to_string(end) +
-            " >= " + to_string(ctxt->prog.code.size()) + ")");
+          "Push immediate exceeds size of program ({} >= {})",
+          end,
+          ctxt->code_size));
+        return;
+      }
 
-      // TODO: parse immediate once and not every time
-      auto pc = ctxt->get_pc() + 1;
+      const auto imm_bytes = ctxt->code + ctxt->get_pc() + 1;
       uint256_t imm = 0;
-      for (int i = 0; i < bytes; i++)
-        imm = (imm << 8) | ctxt->prog.code[pc++];
+      const auto words = intx::as_words(imm);
+      for (size_t i = 0; i < N; i++)
+      {
+        // Immediates are big-endian, so byte i is byte N - 1 - i of the value
+        const auto b = N - 1 - i;
+        words[b / 8] |= uint64_t(imm_bytes[i]) << (8 * (b % 8));
+      }
 
-      ctxt->s.push(imm);
-      ctxt->set_pc(pc);
+      ctxt->s.push_unchecked(imm);
+      ctxt->set_pc(end + 1);
     }
 
     void pop()
     {
-      ctxt->s.pop();
+      ctxt->s.pop_unchecked();
     }
 
+    template <uint8_t N>
     void log()
     {
-      const uint8_t n = get_op() - LOG0;
-      const auto offset = ctxt->s.pop64();
-      const auto size = ctxt->s.pop64();
+      const auto offset = pop64();
+      const auto size = pop64();
 
-      vector<uint256_t> topics(n);
-      for (int i = 0; i < n; i++)
-        topics[i] = ctxt->s.pop();
+      vector<uint256_t> topics(N);
+      for (auto& topic : topics)
+        topic = ctxt->s.pop_unchecked();
+      if (fault)
+        return;
 
+      if (!prepare_mem_access(offset, size))
+        return;
       tx.log_handler.handle(
         {ctxt->acc.get_address(), copy_from_mem(offset, size), topics});
     }
 
     void blockhash()
     {
-      const auto i = ctxt->s.pop64();
+      const auto i = pop64();
+      if (fault)
+        return;
       if (i >= 256)
-        ctxt->s.push(0);
+        ctxt->s.push_unchecked(0);
       else
-        ctxt->s.push(gs.get_block_hash(i % 256));
+        ctxt->s.push_unchecked(gs.get_block_hash(i % 256));
     }
 
     void number()
     {
-      ctxt->s.push(gs.get_current_block().number);
+      ctxt->s.push_unchecked(gs.get_current_block().number);
     }
 
     void gasprice()
     {
-      ctxt->s.push(tx.gas_price);
+      ctxt->s.push_unchecked(tx.gas_price);
     }
 
     void coinbase()
     {
-      ctxt->s.push(gs.get_current_block().coinbase);
+      ctxt->s.push_unchecked(gs.get_current_block().coinbase);
     }
 
     void timestamp()
     {
-      ctxt->s.push(gs.get_current_block().timestamp);
+      ctxt->s.push_unchecked(gs.get_current_block().timestamp);
     }
 
     void difficulty()
     {
-      ctxt->s.push(gs.get_current_block().difficulty);
+      ctxt->s.push_unchecked(gs.get_current_block().difficulty);
     }
 
     void gas()
     {
       // NB: we do not currently track gas. This will always return the tx's
       // initial gas value
-      ctxt->s.push(tx.gas_limit);
+      ctxt->s.push_unchecked(tx.gas_limit);
     }
 
     void gaslimit()
     {
-      ctxt->s.push(gs.get_current_block().gas_limit);
+      ctxt->s.push_unchecked(gs.get_current_block().gas_limit);
     }
 
     void sha3()
     {
-      const auto offset = ctxt->s.pop64();
-      const auto size = ctxt->s.pop64();
-      prepare_mem_access(offset, size);
+      const auto offset = pop64();
+      const auto size = pop64();
+      if (fault)
+        return;
+      if (!prepare_mem_access(offset, size))
+        return;
+
+      const auto data = ctxt->mem.data() + offset;
+      if (sha3_cache && size == Sha3Cache::PREIMAGE_SIZE)
+      {
+        const auto h = sha3_cache->get(data);
+        ctxt->s.push_unchecked(from_big_endian(h.data(), h.size()));
+        return;
+      }
 
       uint8_t h[32];
-      keccak_256(ctxt->mem.data() + offset, static_cast<unsigned int>(size), h);
-      ctxt->s.push(from_big_endian(h, sizeof(h)));
+      keccak_256(data, static_cast<unsigned int>(size), h);
+      ctxt->s.push_unchecked(from_big_endian(h, sizeof(h)));
     }
 
     void return_()
     {
-      const auto offset = ctxt->s.pop64();
-      const auto size = ctxt->s.pop64();
+      const auto offset = pop64();
+      const auto size = pop64();
+      if (fault)
+        return;
+
+      // invoke caller's return handler, handing over this context's memory
+      if (!prepare_mem_access(offset, size))
+        return;
+      ctxt->rh({move(ctxt->mem), offset, size});
+      pop_context();
+    }
+
+    void revert()
+    {
+      const auto offset = pop64();
+      const auto size = pop64();
+      if (fault)
+        return;
 
-      // invoke caller's return handler
-      ctxt->rh(copy_from_mem(offset, size));
+      // invoke caller's revert handler, handing over this context's memory
+      if (!prepare_mem_access(offset, size))
+        return;
+      ctxt->rvh({move(ctxt->mem), offset, size});
       pop_context();
     }
 
+    void invalid()
+    {
+      raise(Exception::fault(
+        ET::illegalInstruction,
+        "Designated invalid opcode at position {}",
+        ctxt->get_pc()));
+    }
+
     void stop()
     {
       // (1) save halt handler
@@ -1216,16 +2512,21 @@ namespace eevm
     void selfdestruct()
     {
       auto recipient = gs.get(pop_addr(ctxt->s));
-      ctxt->acc.pay_to(recipient.acc, ctxt->acc.get_balance());
+      if (!pay(recipient.acc, ctxt->acc.get_balance()))
+        return;
       tx.selfdestruct_list.push_back(ctxt->acc.get_address());
       stop();
     }
 
     void create()
     {
-      const auto contractValue = ctxt->s.pop();
-      const auto offset = ctxt->s.pop64();
-      const auto size = ctxt->s.pop64();
+      const auto contractValue = ctxt->s.pop_unchecked();
+      const auto offset = pop64();
+      const auto size = pop64();
+      if (fault)
+        return;
+      if (!prepare_mem_access(offset, size))
+        return;
       auto initCode = copy_from_mem(offset, size);
 
       const auto newAddress =
@@ -1236,28 +2537,78 @@ namespace eevm
       // TODO: Work out why this fails the test cases
       // ctxt->acc.increment_nonce();
 
-      decltype(auto) newAcc = gs.create(newAddress, contractValue, {});
+      create_at(newAddress, contractValue, move(initCode));
+    }
+
+    void create2()
+    {
+      const auto contractValue = ctxt->s.pop_unchecked();
+      const auto offset = pop64();
+      const auto size = pop64();
+      const auto salt = ctxt->s.pop_unchecked();
+      if (fault)
+        return;
+      if (!prepare_mem_access(offset, size))
+        return;
+      auto initCode = copy_from_mem(offset, size);
+
+      const auto newAddress =
+        generate_address(ctxt->acc.get_address(), salt, initCode);
+
+      create_at(newAddress, contractValue, move(initCode));
+    }
+
+    /// Runs init code in a new context, for an account at newAddress
+    void create_at(
+      const Address& newAddress,
+      const uint256_t& contractValue,
+      vector<uint8_t>&& initCode)
+    {
+      ctxt->return_data.clear();
+
+      // An address which is already in use cannot be created over, but an
+      // existing empty account (eg, one which has been paid) can
+      const auto existing = gs.find(newAddress);
+      if (
+        existing &&
+        (existing->get_code_size() != 0 || existing->get_nonce() != 0))
+      {
+        ctxt->s.push_unchecked(0);
+        return;
+      }
+
+      const auto newAcc = gs.get(newAddress);
 
       // In contract creation, the transaction value is an endowment for the
       // newly created account
-      ctxt->acc.pay_to(newAcc.acc, contractValue);
+      if (!pay(newAcc.acc, contractValue))
+        return;
 
       auto parentContext = ctxt;
-      auto rh = [&newAcc, parentContext](vector<uint8_t> output) {
-        newAcc.acc.set_code(move(output));
-        parentContext->s.push(newAcc.acc.get_address());
+      auto rh = [newAcc, parentContext](ReturnData&& output) {
+        const auto code = output.view();
+        newAcc.acc.set_code({code.begin(), code.end()});
+        parentContext->s.push_unchecked(newAcc.acc.get_address());
+      };
+      auto rvh = [parentContext](ReturnData&& output) {
+        parentContext->return_data = move(output);
+        parentContext->s.push_unchecked(0);
+      };
+      auto hh = [parentContext]() { parentContext->s.push_unchecked(0); };
+      auto eh = [parentContext](const Exception&) {
+        parentContext->s.push_unchecked(0);
       };
-      auto hh = [parentContext]() { parentContext->s.push(0); };
-      auto eh = [parentContext](const Exception&) { parentContext->s.push(0); };
 
       // create new context for init code execution
       push_context(
         ctxt->acc.get_address(),
         newAcc,
         {},
-        std::move(initCode),
+        make_shared<const Program>(move(initCode)),
         0,
+        false,
         rh,
+        rvh,
         hh,
         eh);
     }
@@ -1265,52 +2616,104 @@ namespace eevm
     void call()
     {
       const auto op = get_op();
-      ctxt->s.pop(); // gas limit not used
+      // only checked for native contracts
+      const auto gas = ctxt->s.pop_unchecked();
       const auto addr = pop_addr(ctxt->s);
-      const auto value = op == DELEGATECALL ? 0 : ctxt->s.pop64();
-      const auto offIn = ctxt->s.pop64();
-      const auto sizeIn = ctxt->s.pop64();
-      const auto offOut = ctxt->s.pop64();
-      const auto sizeOut = ctxt->s.pop64();
+      const auto value =
+        (op == DELEGATECALL || op == STATICCALL) ? 0
+                                                 : pop64();
+      const auto offIn = pop64();
+      const auto sizeIn = pop64();
+      const auto offOut = pop64();
+      const auto sizeOut = pop64();
+      if (fault)
+        return;
+
+      if (op == CALL && value != 0 && !require_non_static())
+        return;
+
+      // Check both regions before the call has any effect. Memory is only
+      // expanded to cover them once the callee is known to run.
+      if (
+        !check_mem_access(offIn, sizeIn) || !check_mem_access(offOut, sizeOut))
+        return;
+      ctxt->return_data.clear();
+
+      if (const auto native = natives.find(addr))
+      {
+        call_native(
+          *native, gas, addr, value, offIn, sizeIn, offOut, sizeOut);
+        return;
+      }
 
-      if (addr >= 1 && addr <= 8)
+      if (addr >= 1 && addr <= NativeContracts::max_standard_address(F))
       {
-        // TODO: implement native extensions
-        throw Exception(
+        raise(Exception::fault(
           ET::notImplemented,
-          "Precompiled contracts/native extensions are not implemented.");
+          "No precompiled contract registered at 0x{:x}",
+          addr.low64()));
+        return;
       }
 
       decltype(auto) callee = gs.get(addr);
-      ctxt->acc.pay_to(callee.acc, value);
+      if (!pay(callee.acc, value))
+        return;
       if (!callee.acc.has_code())
       {
-        ctxt->s.push(1);
+        ctxt->s.push_unchecked(1);
         return;
       }
 
-      prepare_mem_access(offOut, sizeOut);
-      auto input = copy_from_mem(offIn, sizeIn);
+      // The callee's input is a view of this context's memory, so size
+      // memory for both regions before taking it
+      ctxt->mem.expand(offIn + sizeIn);
+      ctxt->mem.expand(offOut + sizeOut);
+      const ByteView input(ctxt->mem.data() + offIn, sizeIn);
 
       auto parentContext = ctxt;
-      auto rh =
-        [offOut, sizeOut, parentContext](const vector<uint8_t>& output) {
-          copy_mem_raw(offOut, 0, sizeOut, parentContext->mem, output);
-          parentContext->s.push(1);
-        };
-      auto hh = [parentContext]() { parentContext->s.push(1); };
-      auto he = [parentContext](const Exception&) { parentContext->s.push(0); };
+      parentContext->out_offset = offOut;
+      parentContext->out_size = sizeOut;
+      auto rh = [parentContext](ReturnData&& output) {
+        copy_mem_raw(
+          parentContext->out_offset,
+          0,
+          parentContext->out_size,
+          parentContext->mem,
+          output.view());
+        parentContext->return_data = move(output);
+        parentContext->s.push_unchecked(1);
+      };
+      auto rvh = [parentContext](ReturnData&& output) {
+        copy_mem_raw(
+          parentContext->out_offset,
+          0,
+          parentContext->out_size,
+          parentContext->mem,
+          output.view());
+        parentContext->return_data = move(output);
+        parentContext->s.push_unchecked(0);
+      };
+      auto hh = [parentContext]() { parentContext->s.push_unchecked(1); };
+      auto he = [parentContext](const Exception&) {
+        parentContext->s.push_unchecked(0);
+      };
+
+      // Static-ness is inherited by every nested call
+      const bool is_static = ctxt->is_static || op == STATICCALL;
 
       switch (op)
       {
         case Opcode::CALL:
+        case Opcode::STATICCALL:
           push_context(
             ctxt->acc.get_address(),
             callee,
-            move(input),
-            callee.acc.get_code(),
+            input,
+            programs.load(callee.acc),
             value,
+            is_static,
             rh,
+            rvh,
             hh,
             he);
           break;
@@ -1318,10 +2721,12 @@ namespace eevm
           push_context(
             ctxt->acc.get_address(),
             ctxt->as,
-            move(input),
-            callee.acc.get_code(),
+            input,
+            programs.load(callee.acc),
             value,
+            is_static,
             rh,
+            rvh,
             hh,
             he);
           break;
@@ -1329,10 +2734,12 @@ namespace eevm
           push_context(
             ctxt->caller,
             ctxt->as,
-            move(input),
-            callee.acc.get_code(),
+            input,
+            programs.load(callee.acc),
             ctxt->call_value,
+            is_static,
             rh,
+            rvh,
             hh,
             he);
           break;
@@ -1340,9 +2747,117 @@ namespace eevm
           throw UnexpectedState("Unknown call opcode.");
       }
     }
+
+    /// Runs a native contract synchronously, in place of pushing a context
+    void call_native(
+      NativeContract& native,
+      const uint256_t& gas,
+      const Address& addr,
+      const uint256_t& value,
+      const uint64_t offIn,
+      const uint64_t sizeIn,
+      const uint64_t offOut,
+      const uint64_t sizeOut)
+    {
+      // Size memory for both regions (already checked) first, so that views
+      // into it remain valid while the contract runs
+      ctxt->mem.expand(offIn + sizeIn);
+      ctxt->mem.expand(offOut + sizeOut);
+      const ByteView input(ctxt->mem.data() + offIn, sizeIn);
+
+      if (uint256_t(native.gas(input)) > gas)
+      {
+        ctxt->s.push_unchecked(0);
+        return;
+      }
+
+      decltype(auto) callee = gs.get(addr);
+      if (!pay(callee.acc, value))
+        return;
+
+      NativeOutput output(ctxt->return_data.retain_native());
+      try
+      {
+        native.execute(input, output);
+      }
+      catch (const Exception&)
+      {
+        ctxt->return_data.clear();
+        ctxt->s.push_unchecked(0);
+        return;
+      }
+
+      // As for calls to bytecode, pad short output with zeroes
+      const auto n = min<uint64_t>(output.size(), sizeOut);
+      const auto out = ctxt->mem.data() + offOut;
+      copy(output.data(), output.data() + n, out);
+      fill(out + n, out + sizeOut, 0);
+
+      // Return data only exists from Byzantium, so is only kept from then
+      if (F < Fork::byzantium)
+        ctxt->return_data.clear();
+      ctxt->s.push_unchecked(1);
+    }
   };
 
-  Processor::Processor(GlobalState& gs) : gs(gs) {}
+  template <Fork F>
+  ExecResult Processor::run_fork(
+    Processor& p,
+    Transaction& tx,
+    const Address& caller,
+    AccountState callee,
+    const vector<uint8_t>& input,
+    const uint256_t& call_value,
+    Trace* tr)
+  {
+    return _Processor<F>(p.gs, tx, tr, p.sha3_cache, p.natives, *p.programs)
+      .run(caller, callee, input, call_value);
+  }
+
+  Processor::Runner Processor::select_runner(Fork fork)
+  {
+    switch (fork)
+    {
+      case Fork::homestead:
+        return &run_fork<Fork::homestead>;
+      case Fork::byzantium:
+        return &run_fork<Fork::byzantium>;
+      case Fork::constantinople:
+        return &run_fork<Fork::constantinople>;
+      default:
+        throw UnexpectedState("Unknown fork");
+    }
+  }
+
+  Processor::Processor(GlobalState& gs, Sha3Cache* sha3_cache, Fork fork) :
+    gs(gs),
+    sha3_cache(sha3_cache),
+    natives(NativeContracts::standard(fork)),
+    programs(make_unique<ProgramCache>(DEFAULT_ANALYSIS_CACHE_THRESHOLD)),
+    runner(select_runner(fork))
+  {}
+
+  Processor::~Processor() = default;
+
+  NativeContracts& Processor::get_native_contracts()
+  {
+    return natives;
+  }
+
+  void Processor::set_analysis_cache_threshold(size_t executions)
+  {
+    programs->threshold = executions;
+  }
+
+  size_t Processor::num_cached_programs() const
+  {
+    return programs->size();
+  }
+
+  uint64_t Processor::num_cache_fills() const
+  {
+    return programs->num_fills();
+  }
 
   ExecResult Processor::run(
     Transaction& tx,
@@ -1352,6 +2867,6 @@ namespace eevm
     const uint256_t& call_value,
     Trace* tr)
   {
-    return _Processor(gs, tx, tr).run(caller, callee, input, call_value);
+    return runner(*this, tx, caller, callee, input, call_value, tr);
   }
 } // namespace eevm
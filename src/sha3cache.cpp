@@ -0,0 +1,92 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "eEVM/sha3cache.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace eevm
+{
+  size_t Sha3Cache::PreimageHash::operator()(const Preimage& p) const
+  {
+    // Preimages are typically (key, slot) pairs with most entropy in the low
+    // bytes of each word, so mix all 8-byte chunks rather than a prefix
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < PREIMAGE_SIZE; i += sizeof(uint64_t))
+    {
+      uint64_t w;
+      std::memcpy(&w, p.data() + i, sizeof(w));
+      h = (h ^ w) * 0x100000001b3ull;
+      h ^= h >> 29;
+    }
+    return static_cast<size_t>(h);
+  }
+
+  Sha3Cache::Sha3Cache(size_t max_entries) : max_entries(max_entries)
+  {
+    if (max_entries == 0)
+      throw std::logic_error("Sha3Cache must have non-zero capacity");
+
+    index.reserve(max_entries);
+  }
+
+  KeccakHash Sha3Cache::get(const uint8_t* preimage)
+  {
+    Preimage key;
+    std::memcpy(key.data(), preimage, PREIMAGE_SIZE);
+
+    const auto it = index.find(key);
+    if (it != index.end())
+    {
+      ++stats.hits;
+      entries.splice(entries.begin(), entries, it->second);
+      return it->second->second;
+    }
+
+    ++stats.misses;
+    const auto h = keccak_256(key);
+
+    if (entries.size() == max_entries)
+    {
+      // Reuse the least recently used node rather than reallocating
+      ++stats.evictions;
+      index.erase(entries.back().first);
+      entries.splice(entries.begin(), entries, std::prev(entries.end()));
+      entries.front() = {key, h};
+    }
+    else
+    {
+      entries.emplace_front(key, h);
+    }
+
+    index.emplace(key, entries.begin());
+    return h;
+  }
+
+  size_t Sha3Cache::size() const
+  {
+    return entries.size();
+  }
+
+  size_t Sha3Cache::capacity() const
+  {
+    return max_entries;
+  }
+
+  void Sha3Cache::clear()
+  {
+    entries.clear();
+    index.clear();
+  }
+
+  const Sha3Cache::Stats& Sha3Cache::get_stats() const
+  {
+    return stats;
+  }
+
+  void Sha3Cache::reset_stats()
+  {
+    stats = {};
+  }
+} // namespace eevm
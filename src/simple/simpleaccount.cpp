@@ -7,78 +7,89 @@
 
 namespace eevm
 {
-  Address SimpleAccount::get_address() const
+  uint256_t SimpleAccountBase::get_balance() const
   {
-    return address;
+    return balance;
   }
 
-  void SimpleAccount::set_address(const Address& a)
+  void SimpleAccountBase::set_balance(const uint256_t& b)
   {
-    address = a;
+    balance = b;
   }
 
-  uint256_t SimpleAccount::get_balance() const
+  Account::Nonce SimpleAccountBase::get_nonce() const
   {
-    return balance;
+    return nonce;
   }
 
-  void SimpleAccount::set_balance(const uint256_t& b)
+  void SimpleAccountBase::set_nonce(Nonce n)
   {
-    balance = b;
+    nonce = n;
   }
 
-  Account::Nonce SimpleAccount::get_nonce() const
+  void SimpleAccountBase::increment_nonce()
   {
-    return nonce;
+    ++nonce;
   }
 
-  void SimpleAccount::set_nonce(Nonce n)
+  Code SimpleAccountBase::get_code() const
   {
-    nonce = n;
+    return code ? code->code : Code{};
   }
 
-  void SimpleAccount::increment_nonce()
+  void SimpleAccountBase::set_code(Code&& c)
   {
-    ++nonce;
+    code = share(std::move(c));
+    code_hash = code ? code->hash : empty_code_hash();
+  }
+
+  size_t SimpleAccountBase::get_code_size() const
+  {
+    return code ? code->code.size() : 0;
   }
 
-  Code SimpleAccount::get_code() const
+  uint256_t SimpleAccountBase::get_code_hash() const
   {
-    return code;
+    return code_hash;
   }
 
-  void SimpleAccount::set_code(Code&& c)
+  bool SimpleAccountBase::holds_code_hash() const
   {
-    code = c;
+    return true;
   }
 
-  bool SimpleAccount::has_code()
+  bool SimpleAccountBase::has_code()
   {
-    return !get_code().empty();
+    return code != nullptr;
   }
 
-  bool SimpleAccount::operator==(const Account& a) const
+  bool SimpleAccountBase::operator==(const Account& a) const
   {
     return get_address() == a.get_address() &&
       get_balance() == a.get_balance() && get_nonce() == a.get_nonce() &&
-      get_code() == a.get_code();
+      get_code_hash() == a.get_code_hash();
   }
 
-  void to_json(nlohmann::json& j, const SimpleAccount& a)
+  Address SimpleAccount::get_address() const
   {
-    j["address"] = address_to_hex_string(a.address);
-    j["balance"] = to_hex_string(a.balance);
-    j["nonce"] = to_hex_string(a.nonce);
-    j["code"] = to_hex_string(a.code);
+    return address;
   }
 
-  void from_json(const nlohmann::json& j, SimpleAccount& a)
+  void SimpleAccount::set_address(const Address& a)
   {
-    if (j.find("address") != j.end())
-    {
-      a.address = to_uint256(j["address"]);
-    }
+    address = a;
+  }
 
+  void to_json(nlohmann::json& j, const SimpleAccountBase& a)
+  {
+    j["address"] = address_to_hex_string(a.get_address());
+    j["balance"] = to_hex_string(a.get_balance());
+    j["nonce"] = to_hex_string(a.get_nonce());
+    j["code"] = to_hex_string(a.get_code());
+  }
+
+  void from_json(const nlohmann::json& j, SimpleAccountBase& a)
+  {
     if (j.find("balance") != j.end())
     {
       a.balance = to_uint256(j["balance"]);
@@ -91,7 +102,22 @@ namespace eevm
 
     if (j.find("code") != j.end())
     {
-      a.code = to_bytes(j["code"]);
+      a.set_code(to_bytes(j["code"]));
+    }
+  }
+
+  void to_json(nlohmann::json& j, const SimpleAccount& a)
+  {
+    to_json(j, static_cast<const SimpleAccountBase&>(a));
+  }
+
+  void from_json(const nlohmann::json& j, SimpleAccount& a)
+  {
+    if (j.find("address") != j.end())
+    {
+      a.address = to_uint256(j["address"]);
     }
+
+    from_json(j, static_cast<SimpleAccountBase&>(a));
   }
 } // namespace eevm
@@ -5,36 +5,82 @@
 
 namespace eevm
 {
+  SimpleGlobalState::Handle SimpleGlobalState::allocate(
+    SimpleAccountBase&& acc, SimpleStorage&& st)
+  {
+    if (free_handles.empty())
+    {
+      accounts.push_back(std::move(acc));
+      storage.push_back(std::move(st));
+      return accounts.size() - 1;
+    }
+
+    const auto h = free_handles.back();
+    free_handles.pop_back();
+    accounts[h] = std::move(acc);
+    storage[h] = std::move(st);
+    return h;
+  }
+
+  SimpleGlobalState::Handles::iterator SimpleGlobalState::add(
+    Handles::const_iterator hint,
+    const Address& addr,
+    SimpleAccountBase&& acc,
+    SimpleStorage&& st)
+  {
+    const auto it = handles.emplace_hint(
+      hint, addr, allocate(std::move(acc), std::move(st)));
+    accounts[it->second].address = &it->first;
+    return it;
+  }
+
   void SimpleGlobalState::remove(const Address& addr)
   {
-    accounts.erase(addr);
+    const auto it = handles.find(addr);
+    if (it == handles.end())
+      return;
+
+    // Release the code and storage now, rather than when the handle is reused
+    const auto h = it->second;
+    accounts[h] = {};
+    storage[h] = {};
+    free_handles.push_back(h);
+    handles.erase(it);
   }
 
   AccountState SimpleGlobalState::get(const Address& addr)
   {
-    const auto acc = accounts.find(addr);
-    if (acc != accounts.cend())
-      return acc->second;
-
-    return create(addr, 0, {});
+    // A single probe, which also gives the position at which to insert on a
+    // miss
+    auto it = handles.lower_bound(addr);
+    if (it == handles.end() || it->first != addr)
+      it = add(it, addr, SimpleAccount(addr, 0, {}), {});
+    return at(it->second);
   }
 
   AccountState SimpleGlobalState::create(
     const Address& addr, const uint256_t& balance, const Code& code)
   {
-    insert({SimpleAccount(addr, balance, code), {}});
-
-    return get(addr);
+    assert(handles.find(addr) == handles.end());
+    const auto it =
+      add(handles.end(), addr, SimpleAccount(addr, balance, code), {});
+    return at(it->second);
   }
 
   bool SimpleGlobalState::exists(const Address& addr)
   {
-    return accounts.find(addr) != accounts.end();
+    return handles.find(addr) != handles.end();
+  }
+
+  const Account* SimpleGlobalState::find(const Address& addr)
+  {
+    const auto it = handles.find(addr);
+    return it == handles.end() ? nullptr : &accounts[it->second];
   }
 
   size_t SimpleGlobalState::num_accounts()
   {
-    return accounts.size();
+    return handles.size();
   }
 
   const Block& SimpleGlobalState::get_current_block()
@@ -49,23 +95,45 @@ namespace eevm
 
   void SimpleGlobalState::insert(const StateEntry& p)
   {
-    const auto ib = accounts.insert(std::make_pair(p.first.get_address(), p));
-
-    assert(ib.second);
+    const auto addr = p.first.get_address();
+    assert(handles.find(addr) == handles.end());
+    add(
+      handles.end(), addr, SimpleAccount(p.first), SimpleStorage(p.second));
   }
 
   bool operator==(const SimpleGlobalState& l, const SimpleGlobalState& r)
   {
-    return (l.accounts == r.accounts) && (l.currentBlock == r.currentBlock);
+    if (
+      !(l.currentBlock == r.currentBlock) ||
+      l.handles.size() != r.handles.size())
+      return false;
+
+    // Handles differ with the order of insertion, so compare by address
+    auto li = l.handles.begin();
+    for (const auto& rp : r.handles)
+    {
+      const auto lh = li->second;
+      const auto rh = rp.second;
+      if (
+        li->first != rp.first || !(l.accounts[lh] == r.accounts[rh]) ||
+        !(l.storage[lh] == r.storage[rh]))
+        return false;
+      ++li;
+    }
+    return true;
   }
 
   void to_json(nlohmann::json& j, const SimpleGlobalState& s)
   {
     j["block"] = s.currentBlock;
     auto o = nlohmann::json::array();
-    for (const auto& p : s.accounts)
+    for (const auto& p : s.handles)
     {
-      o.push_back({to_hex_string(p.first), p.second});
+      nlohmann::json acc;
+      to_json(acc, s.accounts[p.second]);
+      o.push_back(
+        {to_hex_string(p.first),
+         nlohmann::json::array({acc, s.storage[p.second]})});
     }
     j["accounts"] = o;
   }
@@ -80,7 +148,11 @@ namespace eevm
     for (const auto& it : j["accounts"].items())
     {
       const auto& v = it.value();
-      a.accounts.insert(make_pair(to_uint256(v[0]), v[1]));
+      const Address addr = to_uint256(v[0]);
+      if (a.handles.find(addr) != a.handles.end())
+        continue;
+      auto e = v[1].get<SimpleGlobalState::StateEntry>();
+      a.add(a.handles.end(), addr, std::move(e.first), std::move(e.second));
     }
   }
 } // namespace eevm
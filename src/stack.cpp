@@ -6,8 +6,8 @@
 #include "eEVM/exception.h"
 #include "eEVM/util.h"
 
-#include <algorithm>
-#include <limits>
+#include <memory>
+#include <new>
 
 using namespace std;
 
@@ -15,79 +15,90 @@ namespace eevm
 {
   using ET = Exception::Type;
 
-  uint256_t Stack::pop()
+  namespace
   {
-    // TODO: don't check size for every single pop, but rather once at the
-    // beginning of each op handler in vm.cpp
-    if (st.empty())
-      throw Exception(ET::outOfBounds, "Stack out of range");
-
-    uint256_t val = st.front();
-    st.pop_front();
-    return val;
-  }
+    // Raw storage: items are constructed as they are pushed, rather than
+    // zeroing the whole buffer for every frame
+    uint256_t* allocate()
+    {
+      return static_cast<uint256_t*>(
+        ::operator new(Stack::MAX_SIZE * sizeof(uint256_t)));
+    }
+  } // namespace
 
-  uint64_t Stack::pop64()
+  Stack::Stack() : base(allocate()), sp(base) {}
+
+  Stack::Stack(const Stack& other) : base(allocate()), sp(base)
   {
-    const auto val = pop();
-    if (val > numeric_limits<uint64_t>::max())
-      throw Exception(
-        ET::outOfBounds,
-        "Value on stack (" + to_hex_string(val) + ") is larger than 2^64");
+    sp = uninitialized_copy(other.base, other.sp, base);
+  }
 
-    return static_cast<uint64_t>(val);
+  Stack& Stack::operator=(const Stack& other)
+  {
+    if (this != &other)
+      sp = uninitialized_copy(other.base, other.sp, base);
+    return *this;
   }
 
-  void Stack::push(const uint256_t& val)
+  Stack::~Stack()
   {
-    if (size() == MAX_SIZE)
-      throw Exception(
-        ET::outOfBounds,
-        "Stack mem exceeded (" + to_string(size()) +
-          " == " + to_string(MAX_SIZE) + ")");
+    ::operator delete(base);
+  }
 
-    try
-    {
-      st.push_front(val);
-    }
-    catch (const std::bad_alloc&)
-    {
-      throw std::runtime_error("bad_alloc while pushing onto stack");
-    }
+  void Stack::underflow() const
+  {
+    throw Exception::fault(ET::outOfBounds, "Stack out of range");
   }
 
-  uint64_t Stack::size() const
+  void Stack::overflow() const
   {
-    return st.size();
+    throw Exception::fault(
+      ET::outOfBounds, "Stack mem exceeded ({} == {})", size(), MAX_SIZE);
   }
 
-  void Stack::swap(uint64_t i)
+  Exception Stack::too_large(const uint256_t& val)
   {
-    if (i >= size())
-      throw Exception(
+    // Printed from its highest non-zero limb, to avoid leading zeros
+    if (val.hi.hi)
+      return Exception::fault(
         ET::outOfBounds,
-        "Swap out of range (" + to_string(i) + " >= " + to_string(size()) +
-          ")");
-
-    std::swap(st[0], st[i]);
+        "Value on stack is larger than 2^64 (0x{:x}{:016x}{:016x}{:016x})",
+        val.hi.hi,
+        val.hi.lo,
+        val.lo.hi,
+        val.lo.lo);
+    if (val.hi.lo)
+      return Exception::fault(
+        ET::outOfBounds,
+        "Value on stack is larger than 2^64 (0x{:x}{:016x}{:016x})",
+        val.hi.lo,
+        val.lo.hi,
+        val.lo.lo);
+    return Exception::fault(
+      ET::outOfBounds,
+      "Value on stack is larger than 2^64 (0x{:x}{:016x})",
+      val.lo.hi,
+      val.lo.lo);
   }
 
-  void Stack::dup(uint64_t a)
+  void Stack::swap_out_of_range(uint64_t i) const
   {
-    if (a >= size())
-      throw Exception(
-        ET::outOfBounds,
-        "Dup out of range (" + to_string(a) + " >= " + to_string(size()) + ")");
+    throw Exception::fault(
+      ET::outOfBounds, "Swap out of range ({} >= {})", i, size());
+  }
 
-    st.push_front(st[a]);
+  void Stack::dup_out_of_range(uint64_t a) const
+  {
+    throw Exception::fault(
+      ET::outOfBounds, "Dup out of range ({} >= {})", a, size());
   }
 
   std::ostream& operator<<(std::ostream& os, const Stack& s)
   {
     int i = 0;
     os << std::dec;
-    for (const auto& elem : s.st)
-      os << fmt::format(" {}: {}", i++, to_hex_string(elem)) << std::endl;
+    for (auto it = s.sp; it != s.base;)
+      os << fmt::format(" {}: {}", i++, to_hex_string(*--it)) << std::endl;
     return os;
   }
 } // namespace eevm
@@ -56,4 +56,50 @@ namespace eevm
 
     return from_big_endian(buffer + 12u, 20u);
   }
+
+  Address generate_address(
+    const Address& sender,
+    const uint256_t& salt,
+    const vector<uint8_t>& init_code)
+  {
+    // keccak256(0xff ++ sender ++ salt ++ keccak256(init_code))
+    uint8_t preimage[1u + 20u + 32u + 32u];
+    preimage[0] = 0xff;
+
+    uint8_t sender_word[32u];
+    to_big_endian(sender, sender_word);
+    copy(sender_word + 12u, sender_word + 32u, preimage + 1u);
+    to_big_endian(salt, preimage + 21u);
+    keccak_256(
+      init_code.data(),
+      static_cast<unsigned int>(init_code.size()),
+      preimage + 53u);
+
+    uint8_t buffer[32u];
+    keccak_256(preimage, sizeof(preimage), buffer);
+
+    return from_big_endian(buffer + 12u, 20u);
+  }
+
+  vector<string> to_checksum_addresses(const vector<Address>& addresses)
+  {
+    vector<string> hexes;
+    hexes.reserve(addresses.size());
+    for (const auto& a : addresses)
+      hexes.push_back(address_to_hex_string(a));
+
+    // Hash the hex digits, skipping the "0x" prefix
+    vector<KeccakInput> inputs;
+    inputs.reserve(hexes.size());
+    for (const auto& s : hexes)
+      inputs.push_back({(const uint8_t*)s.data() + 2, s.size() - 2});
+
+    vector<KeccakHash> hashes(inputs.size());
+    keccak_256_batch(inputs.data(), inputs.size(), hashes.data());
+
+    for (size_t i = 0; i < hexes.size(); ++i)
+      apply_checksum(hexes[i], hashes[i]);
+
+    return hexes;
+  }
 } // namespace eevm
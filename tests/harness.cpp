@@ -108,7 +108,8 @@ void run_test_case(
 
       CHECK(gs.exists(callee));
 
-      Processor p(gs);
+      // The standard vmTests target Homestead
+      Processor p(gs, nullptr, Fork::homestead);
       Trace* tr(nullptr);
 
 #ifdef RECORD_TRACE
@@ -2,23 +2,55 @@
 // Licensed under the MIT License.
 
 #include "eEVM/bigint.h"
+#include "eEVM/codestore.h"
 #include "eEVM/disassembler.h"
+#include "eEVM/memory.h"
 #include "eEVM/opcode.h"
+#include "eEVM/opcodeinfo.h"
+#include "eEVM/precompiled.h"
 #include "eEVM/processor.h"
 #include "eEVM/simple/simpleaccount.h"
 #include "eEVM/simple/simpleglobalstate.h"
+#include "eEVM/stack.h"
 #include "eEVM/util.h"
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <atomic>
+#include <cstdlib>
 #include <doctest/doctest.h>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <nlohmann/json.hpp>
+#include <random>
+#include <unordered_set>
 #include <vector>
 
 using namespace std;
 using namespace eevm;
 
+// Heap allocations made by the whole binary, so that tests can bound those
+// made by a particular operation
+static std::atomic<size_t> allocations{0};
+
+void* operator new(std::size_t size)
+{
+  ++allocations;
+  if (const auto p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
 TEST_CASE(
   "from_json/to_json are mutually inverse" * doctest::test_suite("json"))
 {
@@ -193,6 +225,44 @@ TEST_CASE("util" * doctest::test_suite("util"))
     }
   }
 
+  SUBCASE("keccak_256_batch")
+  {
+    // Lengths either side of the 136-byte rate boundary, in shuffled order so
+    // that lanes in a group need different numbers of blocks
+    std::vector<std::vector<uint8_t>> inputs;
+    for (size_t len = 0; len < 300; ++len)
+    {
+      std::vector<uint8_t> v((len * 37) % 300);
+      for (size_t i = 0; i < v.size(); ++i)
+        v[i] = static_cast<uint8_t>(len + i * 13);
+      inputs.push_back(v);
+    }
+
+    for (const size_t n : {0, 1, 3, 4, 5, 8, 9, 13, 17, 300})
+    {
+      INFO("Batch of " << n);
+      const std::vector<std::vector<uint8_t>> batch(
+        inputs.begin(), inputs.begin() + n);
+      const auto hashes = keccak_256_batch(batch);
+      REQUIRE(hashes.size() == n);
+      for (size_t i = 0; i < n; ++i)
+        REQUIRE(hashes[i] == keccak_256(batch[i]));
+    }
+  }
+
+  SUBCASE("to_checksum_addresses")
+  {
+    std::vector<Address> addresses;
+    for (uint64_t i = 0; i < 21; ++i)
+      addresses.push_back(
+        to_uint256("0x5aaeb6053f3e94c9b9a09f33669435e7ef1beaed") * (i + 1));
+
+    const auto checksums = to_checksum_addresses(addresses);
+    REQUIRE(checksums.size() == addresses.size());
+    for (size_t i = 0; i < addresses.size(); ++i)
+      REQUIRE(checksums[i] == to_checksum_address(addresses[i]));
+  }
+
   SUBCASE("to_checksum_address")
   {
     const Address t0 = to_uint256("0x5aaeb6053f3e94c9b9a09f33669435e7ef1beaed");
@@ -218,6 +288,236 @@ TEST_CASE("util" * doctest::test_suite("util"))
   }
 }
 
+TEST_CASE("sha3Cache" * doctest::test_suite("util"))
+{
+  Sha3Cache cache(2);
+
+  std::array<uint8_t, Sha3Cache::PREIMAGE_SIZE> a{}, b{}, c{};
+  a[31] = 1;
+  b[31] = 2;
+  c[63] = 3;
+
+  REQUIRE(cache.get(a.data()) == keccak_256(a));
+  REQUIRE(cache.get(b.data()) == keccak_256(b));
+  REQUIRE(cache.get(a.data()) == keccak_256(a));
+  CHECK(cache.get_stats().hits == 1);
+  CHECK(cache.get_stats().misses == 2);
+
+  // b is least recently used, so is evicted
+  REQUIRE(cache.get(c.data()) == keccak_256(c));
+  CHECK(cache.size() == 2);
+  CHECK(cache.get_stats().evictions == 1);
+
+  REQUIRE(cache.get(a.data()) == keccak_256(a));
+  CHECK(cache.get_stats().hits == 2);
+  REQUIRE(cache.get(b.data()) == keccak_256(b));
+  CHECK(cache.get_stats().misses == 4);
+  CHECK(cache.get_stats().hit_rate() == doctest::Approx(2.0 / 6.0));
+
+  cache.reset_stats();
+  cache.clear();
+  CHECK(cache.size() == 0);
+  CHECK(cache.get_stats().hit_rate() == 0.0);
+}
+
+/// Concatenates 32-byte big-endian encodings of the given values
+static vector<uint8_t> words(std::initializer_list<uint256_t> values)
+{
+  vector<uint8_t> out;
+  for (const auto& v : values)
+  {
+    uint8_t word[32];
+    to_big_endian(v, word);
+    out.insert(out.end(), word, word + 32);
+  }
+  return out;
+}
+
+TEST_CASE("precompiled" * doctest::test_suite("precompiled"))
+{
+  using namespace intx;
+
+  SUBCASE("ecrecover")
+  {
+    const auto input = words(
+      {0x456e9aea5e197a1f1af7a3e85a3212fa4049a3ba34c2289b4c860fc0b0c64ef3_u256,
+       28,
+       0x9242685bf161793cc25603c231bc2f568eb630ea16aa137d2664ac8038825608_u256,
+       0x4f8ae3bd7535248d0bd448298cc2e2071e56992d0774dc340c368ae950852ada_u256});
+    CHECK(
+      precompiled::ecrecover(input) ==
+      words({0x7156526fbd7a3c72969b54f64e42c10fbb768c8a_u256}));
+
+    // Invalid recovery id
+    auto bad = input;
+    bad[63] = 29;
+    CHECK(precompiled::ecrecover(bad).empty());
+  }
+
+  SUBCASE("hashes")
+  {
+    const vector<uint8_t> abc = {'a', 'b', 'c'};
+    CHECK(
+      precompiled::sha256(abc) ==
+      to_bytes(
+        "0xba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+    CHECK(
+      precompiled::ripemd160(abc) ==
+      words({0x8eb208f7e05d987a9b044a8e98c6b087f15a0bfc_u256}));
+    CHECK(precompiled::identity(abc) == abc);
+
+    // Longer than one block, to cover any accelerated path
+    const vector<uint8_t> long_input(1000, 'x');
+    CHECK(
+      precompiled::sha256(long_input) ==
+      to_bytes(
+        "0x44f8354494a5ba03ba1792a8d3e9c534c47a9181980fde7a3f44b06ef2ae7c7f"));
+  }
+
+  SUBCASE("modexp")
+  {
+    // Fermat: 3^(p-1) mod p = 1, for p = 2^256 - 2^32 - 977
+    const auto p =
+      0xfffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f_u256;
+    auto input = words({1, 32, 32});
+    input.push_back(3);
+    const auto em = words({p - 1, p});
+    input.insert(input.end(), em.begin(), em.end());
+    CHECK(precompiled::modexp(input) == words({1}));
+    // EIP-198: 32^2 * 255 iterations / 20
+    CHECK(precompiled::modexp_gas(input) == 13056);
+    // Larger operands are cheaper per byte squared
+    auto wide = words({65, 1, 65});
+    wide.resize(wide.size() + 65 + 1 + 65, 0);
+    wide[96 + 65] = 3;
+    CHECK(
+      precompiled::modexp_gas(wide) == (65 * 65 / 4 + 96 * 65 - 3072) / 20);
+
+    // Zero modulus gives zeroes; empty modulus gives empty output
+    CHECK(precompiled::modexp(words({1, 1, 4})) == vector<uint8_t>(4, 0));
+    CHECK(precompiled::modexp(words({1, 1, 0})).empty());
+
+    // Even modulus wider than a word: 2^1000 mod (2^520 - 2)
+    auto big = words({2, 2, 66});
+    const vector<uint8_t> be = {0x00, 0x02, 0x03, 0xe8};
+    big.insert(big.end(), be.begin(), be.end());
+    vector<uint8_t> m(66, 0xff);
+    m[0] = 0x00;
+    m[1] = 0xff;
+    m[65] = 0xfe;
+    big.insert(big.end(), m.begin(), m.end());
+    // 2^1000 = 2^480 * 2^520 = 2^480 * 2 (mod 2^520 - 2)
+    vector<uint8_t> expected(66, 0);
+    expected[66 - 61] = 0x02;
+    CHECK(precompiled::modexp(big) == expected);
+
+    CHECK_THROWS_AS(
+      precompiled::modexp(words({1, 1, 1u << 20})), eevm::Exception);
+  }
+
+  SUBCASE("alt_bn128")
+  {
+    const auto g = words({1, 2});
+    const auto two_g = words(
+      {0x030644e72e131a029b85045b68181585d97816a916871ca8d3c208c16d87cfd3_u256,
+       0x15ed738c0e0a7c92e7845f96b2ae9c0a68a6a449e3538fc7ff3ebf7a5a18a2c4_u256});
+
+    auto add_input = g;
+    add_input.insert(add_input.end(), g.begin(), g.end());
+    CHECK(precompiled::bn256_add(add_input) == two_g);
+
+    auto mul_input = g;
+    const auto two = words({2});
+    mul_input.insert(mul_input.end(), two.begin(), two.end());
+    CHECK(precompiled::bn256_mul(mul_input) == two_g);
+
+    // Multiplying by the group order gives the point at infinity
+    mul_input = g;
+    const auto order = words(
+      {0x30644e72e131a029b85045b68181585d2833e84879b9709143e1f593f0000001_u256});
+    mul_input.insert(mul_input.end(), order.begin(), order.end());
+    CHECK(precompiled::bn256_mul(mul_input) == vector<uint8_t>(64, 0));
+
+    CHECK_THROWS_AS(precompiled::bn256_add(words({1, 3})), eevm::Exception);
+
+    // Generator of G2, imaginary parts first
+    const auto g2 = words(
+      {0x198e9393920d483a7260bfb731fb5d25f1aa493335a9e71297e485b7aef312c2_u256,
+       0x1800deef121f1e76426a00665e5c4479674322d4f75edadd46debd5cd992f6ed_u256,
+       0x090689d0585ff075ec9e99ad690c3395bc4b313370b38ef355acdadcd122975b_u256,
+       0x12c85ea5db8c6deb4aab71808dcb408fe3d1e7690c43d37b4ce6cc0166fa7daa_u256});
+    const auto neg_g = words(
+      {1,
+       0x30644e72e131a029b85045b68181585d97816a916871ca8d3c208c16d87cfd45_u256});
+
+    const auto pair = [&](const vector<uint8_t>& p) {
+      auto v = p;
+      v.insert(v.end(), g2.begin(), g2.end());
+      return v;
+    };
+    const auto concat = [](vector<uint8_t> a, const vector<uint8_t>& b) {
+      a.insert(a.end(), b.begin(), b.end());
+      return a;
+    };
+
+    CHECK(precompiled::bn256_pairing(ByteView()) == words({1}));
+    // e(G1, G2) != 1
+    CHECK(precompiled::bn256_pairing(pair(g)) == words({0}));
+    // e(2 G1, G2) e(-G1, G2) e(-G1, G2) == 1
+    CHECK(
+      precompiled::bn256_pairing(
+        concat(concat(pair(two_g), pair(neg_g)), pair(neg_g))) == words({1}));
+    CHECK(
+      precompiled::bn256_pairing(concat(pair(two_g), pair(neg_g))) ==
+      words({0}));
+
+    CHECK_THROWS_AS(
+      precompiled::bn256_pairing(vector<uint8_t>(191, 0)), eevm::Exception);
+  }
+
+  SUBCASE("blake2f")
+  {
+    // EIP-152 test vector 5: 12 rounds over "abc"
+    const auto input = to_bytes(
+      "0x0000000c48c9bdf267e6096a3ba7ca8485ae67bb2bf894fe72f36e3cf1361d5f3af5"
+      "4fa5d182e6ad7f520e511f6c3e2b8c68059b6bbd41fbabd9831f79217e1319cde05b61"
+      "6263000000000000000000000000000000000000000000000000000000000000000000"
+      "0000000000000000000000000000000000000000000000000000000000000000000000"
+      "0000000000000000000000000000000000000000000000000000000000000000000000"
+      "0000000000000000000000000000000000000000000003000000000000000000000000"
+      "00000001");
+    CHECK(
+      precompiled::blake2f(input) ==
+      to_bytes(
+        "0xba80a53f981c4d0d6a2797b69f12f6e94c212f14685ac4b74b12bb6fdbffa2d1"
+        "7d87c5392aab792dc252d5de4533cc9518d38aa8dbf1925ab92386edd4009923"));
+
+    auto bad_flag = input;
+    bad_flag.back() = 2;
+    CHECK_THROWS_AS(precompiled::blake2f(bad_flag), eevm::Exception);
+    CHECK_THROWS_AS(
+      precompiled::blake2f(ByteView(input.data(), input.size() - 1)),
+      eevm::Exception);
+  }
+
+  SUBCASE("gas schedule")
+  {
+    // Byzantium's prices, which Constantinople kept
+    const auto standard = NativeContracts::standard();
+    const std::vector<uint8_t> pairs(2 * 192, 0);
+    CHECK(standard.find(0x06)->gas({}) == 500);
+    CHECK(standard.find(0x07)->gas({}) == 40000);
+    CHECK(standard.find(0x08)->gas({}) == 100000);
+    CHECK(standard.find(0x08)->gas(pairs) == 100000 + 2 * 80000);
+
+    // Only the precompiles each fork has are registered
+    CHECK(!standard.find(0x09));
+    const auto homestead = NativeContracts::standard(Fork::homestead);
+    CHECK(homestead.find(0x04));
+    CHECK(!homestead.find(0x05));
+  }
+}
+
 TEST_CASE("byteExport" * doctest::test_suite("primitive"))
 {
   std::array<uint8_t, 32> raw;
@@ -317,6 +617,328 @@ TEST_CASE("byteExport" * doctest::test_suite("primitive"))
   }
 }
 
+TEST_CASE("opcodeInfo" * doctest::test_suite("primitive"))
+{
+  for (uint8_t n = 1; n <= 32; ++n)
+  {
+    const auto& push = op_info(Opcode::PUSH1 + n - 1);
+    CHECK(push.immediate_bytes == n);
+    CHECK(push.stack_in == 0);
+    CHECK(push.stack_out == 1);
+  }
+  for (uint8_t n = 1; n <= 16; ++n)
+  {
+    const auto& dup = op_info(Opcode::DUP1 + n - 1);
+    CHECK(dup.stack_in == n);
+    CHECK(dup.stack_out == n + 1);
+    const auto& swap = op_info(Opcode::SWAP1 + n - 1);
+    CHECK(swap.stack_in == n + 1);
+    CHECK(swap.stack_out == n + 1);
+  }
+  for (uint8_t n = 0; n <= 4; ++n)
+  {
+    const auto& log = op_info(Opcode::LOG0 + n);
+    CHECK(log.stack_in == n + 2);
+    CHECK(log.has(OpInfo::writes_state));
+  }
+
+  CHECK(op_info(Opcode::ADD).gas == 3);
+  CHECK(op_info(Opcode::CALL).stack_in == 7);
+  CHECK(op_info(Opcode::JUMPI).has(OpInfo::jump));
+  CHECK(op_info(Opcode::RETURN).has(OpInfo::terminator));
+  CHECK(op_info(Opcode::SLOAD).has(OpInfo::reads_state));
+  CHECK(!op_info(Opcode::SLOAD).has(OpInfo::writes_state));
+  CHECK(!op_info(Opcode::INVALID).has(OpInfo::undefined));
+  CHECK(op_info(0x0c).has(OpInfo::undefined));
+  CHECK(std::string(op_info(0x0c).mnemonic) == "INVALID");
+
+  size_t defined = 0;
+  for (const auto& info : op_table)
+    defined += !info.has(OpInfo::undefined);
+  CHECK(defined == 140);
+
+  // The disassembler reads the same table
+  const auto op = Disassembler::getOp(Opcode::PUSH2);
+  CHECK(std::string(op.mnemonic) == "PUSH2");
+  CHECK(op.immediate_bytes == 2);
+  CHECK(op.gas == 3);
+}
+
+TEST_CASE("memory" * doctest::test_suite("primitive"))
+{
+  Memory mem;
+  CHECK(mem.size() == 0);
+  CHECK(mem.cost() == 0);
+
+  SUBCASE("grows in whole words")
+  {
+    mem.expand(1);
+    CHECK(mem.size() == 32);
+    mem.expand(32);
+    CHECK(mem.size() == 32);
+    mem.expand(33);
+    CHECK(mem.size() == 64);
+    CHECK(mem.words() == 2);
+    mem.expand(0);
+    CHECK(mem.size() == 64);
+  }
+
+  SUBCASE("expansion cost")
+  {
+    mem.expand(32);
+    CHECK(mem.cost() == 3);
+    mem.expand(32 * 512);
+    CHECK(mem.cost() == 3 * 512 + 512);
+    mem.expand(32 * 1024);
+    CHECK(mem.cost() == 3 * 1024 + 2048);
+  }
+
+  SUBCASE("contents survive growth and reads are zero")
+  {
+    // Grow from the heap into mapped pages, and then across remappings
+    uint64_t written = 0;
+    const auto limit = 4 * Memory::MAP_THRESHOLD;
+    for (uint64_t end = 1; end < limit; end = 2 * end + 1)
+    {
+      mem.expand(end);
+      for (uint64_t i = written; i < mem.size(); ++i)
+        REQUIRE(mem[i] == 0);
+      for (uint64_t i = written; i < end; ++i)
+        mem[i] = static_cast<uint8_t>(i * 7);
+      written = end;
+
+      for (uint64_t i = 0; i < written; ++i)
+        REQUIRE(mem[i] == static_cast<uint8_t>(i * 7));
+    }
+
+    Memory moved(std::move(mem));
+    CHECK(mem.size() == 0);
+    CHECK(moved.size() >= written);
+    CHECK(moved[written - 1] == static_cast<uint8_t>((written - 1) * 7));
+  }
+}
+
+TEST_CASE("codeStore" * doctest::test_suite("primitive"))
+{
+  auto& store = CodeStore::instance();
+  const auto before = store.size();
+  const Code code = {Opcode::PUSH1, 0x2a, Opcode::STOP};
+  {
+    SimpleAccount a(0x1, 0, code);
+    SimpleAccount b(0x2, 0, code);
+    CHECK(store.size() == before + 1);
+    CHECK(a.get_code() == code);
+    CHECK(a.get_code_hash() == from_big_endian(keccak_256(code).data()));
+    CHECK(b.get_code_hash() == a.get_code_hash());
+
+    b.set_code({Opcode::STOP});
+    CHECK(store.size() == before + 2);
+    CHECK(a.get_code() == code);
+  }
+  // Dropped once no account holds it
+  CHECK(store.size() == before);
+
+  SimpleAccount empty;
+  CHECK(!empty.has_code());
+  CHECK(
+    empty.get_code_hash() ==
+    to_uint256(
+      "0xc5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470"));
+  CHECK(empty.get_code_hash() == empty_code_hash());
+}
+
+TEST_CASE("simpleGlobalState" * doctest::test_suite("primitive"))
+{
+  SimpleGlobalState gs;
+  auto first = gs.create(0x1, 100, {Opcode::STOP});
+  first.st.store(1, 2);
+
+  SUBCASE("records do not move as accounts are added")
+  {
+    const auto acc = &first.acc;
+    for (uint64_t i = 2; i < 2000; ++i)
+      gs.get(i).acc.set_balance(i);
+    CHECK(gs.num_accounts() == 1999);
+    CHECK(&gs.get(0x1).acc == acc);
+    CHECK(gs.get_balance(0x1) == 100);
+    CHECK(gs.get_balance(1999) == 1999);
+    CHECK(gs.get(0x1).st.load(1) == 2);
+  }
+
+  SUBCASE("removed accounts come back empty")
+  {
+    gs.remove(0x1);
+    CHECK(!gs.exists(0x1));
+    CHECK(gs.find(0x1) == nullptr);
+
+    auto again = gs.get(0x1);
+    CHECK(again.acc.get_balance() == 0);
+    CHECK(!again.acc.has_code());
+    CHECK(again.st.load(1) == 0);
+
+    // A removed account's handle may be reused by another address
+    gs.remove(0x1);
+    auto other = gs.create(0x2, 5, {});
+    CHECK(other.acc.get_address() == Address(0x2));
+    CHECK(gs.num_accounts() == 1);
+  }
+
+  SUBCASE("records refer to the address they are held under")
+  {
+    const Code code = {Opcode::PUSH1, 0x01, Opcode::STOP};
+    gs.get(0x1).acc.set_code(Code(code));
+    CHECK(
+      gs.get_code_hash(0x1) == from_big_endian(keccak_256(code).data()));
+    gs.get(0x1).acc.set_code({});
+    CHECK(gs.get_code_hash(0x1) == empty_code_hash());
+
+    gs.create(0x2, 200, {});
+    const nlohmann::json j = gs;
+    const auto copy = j.get<SimpleGlobalState>();
+    CHECK(copy == gs);
+    CHECK(gs.find(0x2)->get_address() == Address(0x2));
+    CHECK(j["accounts"][1][1][0]["address"] == address_to_hex_string(0x2));
+  }
+
+  SUBCASE("equality does not depend on order of creation")
+  {
+    gs.create(0x2, 200, {});
+    SimpleGlobalState other;
+    other.create(0x2, 200, {});
+    other.create(0x1, 100, {Opcode::STOP}).st.store(1, 2);
+    CHECK(gs == other);
+
+    other.get(0x2).st.store(3, 4);
+    CHECK(!(gs == other));
+  }
+}
+
+TEST_CASE("globalStateDefaults" * doctest::test_suite("primitive"))
+{
+  // A backend written against the original interface, overriding neither
+  // exists nor find
+  struct Minimal : public GlobalState
+  {
+    SimpleGlobalState inner;
+
+    void remove(const Address& addr) override
+    {
+      inner.remove(addr);
+    }
+
+    AccountState get(const Address& addr) override
+    {
+      return inner.get(addr);
+    }
+
+    AccountState create(
+      const Address& addr, const uint256_t& balance, const Code& code) override
+    {
+      return inner.create(addr, balance, code);
+    }
+
+    const Block& get_current_block() override
+    {
+      return inner.get_current_block();
+    }
+
+    uint256_t get_block_hash(uint8_t offset) override
+    {
+      return inner.get_block_hash(offset);
+    }
+  } gs;
+
+  CHECK(!gs.exists(0x1));
+  CHECK(gs.find(0x1) == nullptr);
+  CHECK(gs.get_balance(0x1) == 0);
+  CHECK(gs.get_code_hash(0x1) == empty_code_hash());
+
+  gs.create(0x2, 7, {});
+  CHECK(gs.exists(0x2));
+  REQUIRE(gs.find(0x2) != nullptr);
+  CHECK(gs.get_balance(0x2) == 7);
+
+  gs.create(0x3, 0, {Opcode::STOP});
+  CHECK(gs.exists(0x3));
+  CHECK(gs.get_code_size(0x3) == 1);
+}
+
+TEST_CASE("stack" * doctest::test_suite("primitive"))
+{
+  Stack s;
+  for (uint64_t i = 1; i <= 4; ++i)
+    s.push(i);
+  CHECK(s.size() == 4);
+
+  SUBCASE("dup and swap count from the top")
+  {
+    s.dup<3>();
+    CHECK(s.size() == 5);
+    s.swap(2);
+    CHECK(s.pop64() == 3);
+    CHECK(s.pop64() == 4);
+    CHECK(s.pop64() == 1);
+    s.dup(0);
+    CHECK(s.pop64() == 2);
+    s.swap<1>();
+    CHECK(s.pop64() == 1);
+    CHECK(s.pop64() == 2);
+    CHECK(s.size() == 0);
+  }
+
+  SUBCASE("bounds")
+  {
+    CHECK_THROWS_AS(s.dup(4), Exception);
+    CHECK_THROWS_AS(s.swap<4>(), Exception);
+
+    while (s.size() < Stack::MAX_SIZE)
+      s.push(0);
+    CHECK_THROWS_AS(s.push(0), Exception);
+    CHECK_THROWS_AS(s.dup<0>(), Exception);
+
+    while (s.size() > 0)
+      s.pop();
+    CHECK_THROWS_AS(s.pop(), Exception);
+    CHECK_THROWS_AS(s.pop64(), Exception);
+    CHECK_THROWS_AS(s.top(), Exception);
+  }
+
+  SUBCASE("copies are independent")
+  {
+    Stack copy(s);
+    copy.push(5);
+    CHECK(s.size() == 4);
+    CHECK(copy.pop64() == 5);
+    CHECK(copy.pop64() == 4);
+    CHECK(s.pop64() == 4);
+  }
+}
+
+TEST_CASE("address" * doctest::test_suite("primitive"))
+{
+  static_assert(sizeof(Address) == Address::SIZE, "Address is 20 bytes");
+
+  const auto word = to_uint256(
+    "0xffffffffffffffffffffffff0102030405060708090a0b0c0d0e0f1011121314");
+  const Address a = word;
+  CHECK(
+    uint256_t(a) ==
+    to_uint256("0x0102030405060708090a0b0c0d0e0f1011121314"));
+  CHECK(a.data()[0] == 0x01);
+  CHECK(a.data()[Address::SIZE - 1] == 0x14);
+  CHECK(Address(uint256_t(a)) == a);
+
+  // Bytewise order is numeric order
+  CHECK(Address(0xff) < Address(0x100));
+  CHECK(Address(uint256_t(1) << 152) > Address(~uint64_t(0)));
+  CHECK(Address(7) <= Address(7));
+  CHECK(a != Address(0x14));
+
+  std::unordered_set<Address> seen = {a, Address(1), Address(1)};
+  CHECK(seen.size() == 2);
+  CHECK(seen.count(word) == 1);
+}
+
 TEST_CASE("addressGeneration" * doctest::test_suite("rlp"))
 {
   Address sender = to_uint256("0x6ac7ea33f8831ea9dcc53393aaa88b25a785dbf0");
@@ -332,6 +954,18 @@ TEST_CASE("addressGeneration" * doctest::test_suite("rlp"))
 
   Address nonce3 = generate_address(sender, 3u);
   CHECK(nonce3 == to_uint256("0xfffd933a0bc612844eaf0c6fe3e5b8e9b6c1d19c"));
+
+  // CREATE2 examples from EIP-1014
+  CHECK(
+    generate_address(0, 0, {0x00}) ==
+    to_uint256("0x4d1a2e2bb4f88f0250f26ffff098b0b30b26bf38"));
+  CHECK(
+    generate_address(
+      to_uint256("0xdeadbeef00000000000000000000000000000000"), 0, {0x00}) ==
+    to_uint256("0xb928f69bb1d91cd65274e3c79d8986362984fda3"));
+  CHECK(
+    generate_address(0, 0, {}) ==
+    to_uint256("0xe33c0c7f7df4809055c3eba6c09cfe4baf1bd9e0"));
 }
 
 TEST_CASE("vmExecution" * doctest::test_suite("vm"))
@@ -399,5 +1033,1432 @@ TEST_CASE("vmExecution" * doctest::test_suite("vm"))
       CHECK(it != code.end());
     }
     CHECK(std::next(it) == code.end());
+
+    // Events hold the live items of the stack before each instruction
+    REQUIRE(tr.events.size() > 2);
+    const auto& add = tr.events[2];
+    REQUIRE(add.op == Opcode::ADD);
+    CHECK(add.stack == std::vector<uint256_t>{a, b});
+    CHECK(
+      fmt::format("{}", add) ==
+      "4 (1): ADD\nstack before:\n 0: 0xfe\n 1: 0xed\n");
+  }
+
+  SUBCASE("sha3 with cache")
+  {
+    // Hash the same 64-byte (key, slot) preimage twice
+    constexpr uint8_t key = 0x42;
+    constexpr uint8_t slot = 0x01;
+    const std::vector<uint8_t> sha3_code = {
+      Opcode::PUSH1, key,  Opcode::PUSH1, 0x00, Opcode::MSTORE,
+      Opcode::PUSH1, slot, Opcode::PUSH1, 0x20, Opcode::MSTORE,
+      Opcode::PUSH1, 0x40, Opcode::PUSH1, 0x00, Opcode::SHA3,
+      Opcode::PUSH1, 0x40, Opcode::PUSH1, 0x00, Opcode::SHA3,
+      Opcode::EQ,    Opcode::PUSH1, 0x40, Opcode::PUSH1, 0x00,
+      Opcode::SHA3,  Opcode::PUSH1, 0x00, Opcode::MSTORE, Opcode::PUSH1,
+      0x40,          Opcode::MSTORE, Opcode::PUSH1, 0x60, Opcode::PUSH1,
+      0x00,          Opcode::RETURN};
+
+    gs.create(to, {}, sha3_code);
+
+    Sha3Cache cache;
+    Processor cp(gs, &cache);
+    const auto e = cp.run(tx, from, gs.get(to), {}, 0);
+
+    REQUIRE(e.er == ExitReason::returned);
+    REQUIRE(e.output.size() == 0x60);
+
+    std::array<uint8_t, 64> preimage{};
+    preimage[31] = key;
+    preimage[63] = slot;
+    const auto expected = keccak_256(preimage);
+    CHECK(std::equal(expected.begin(), expected.end(), e.output.begin()));
+    CHECK(e.output[0x5f] == 1);
+
+    CHECK(cache.get_stats().misses == 1);
+    CHECK(cache.get_stats().hits == 2);
+  }
+
+  SUBCASE("call native contracts")
+  {
+    // Store 0x42, CALL addr with it as input and output to 0x20, then
+    // return memory and the CALL's success flag
+    uint256_t caller = to;
+    const auto call_on = [&](Processor& proc, uint8_t addr, uint8_t gas) {
+      const std::vector<uint8_t> code = {
+        Opcode::PUSH1, 0x42, Opcode::PUSH1, 0x00, Opcode::MSTORE,
+        Opcode::PUSH1, 0x20, Opcode::PUSH1, 0x20, Opcode::PUSH1,
+        0x20,          Opcode::PUSH1, 0x00, Opcode::PUSH1, 0x00,
+        Opcode::PUSH1, addr, Opcode::PUSH1, gas,  Opcode::CALL,
+        Opcode::PUSH1, 0x40, Opcode::MSTORE, Opcode::PUSH1, 0x60,
+        Opcode::PUSH1, 0x00, Opcode::RETURN};
+      caller += 1;
+      gs.create(caller, {}, code);
+      return proc.run(tx, from, gs.get(caller), {}, 0);
+    };
+    const auto call = [&](uint8_t addr, uint8_t gas) {
+      return call_on(p, addr, gas);
+    };
+
+    // Identity costs 15 + 3 per word
+    auto e = call(0x04, 18);
+    REQUIRE(e.er == ExitReason::returned);
+    REQUIRE(e.output.size() == 0x60);
+    CHECK(e.output[0x3f] == 0x42);
+    CHECK(e.output[0x5f] == 1);
+
+    e = call(0x04, 17);
+    REQUIRE(e.er == ExitReason::returned);
+    CHECK(e.output[0x3f] == 0x00);
+    CHECK(e.output[0x5f] == 0);
+
+    // Replace identity with a native extension which fails
+    auto& natives = p.get_native_contracts();
+    natives.add(0x04, [](ByteView) -> std::vector<uint8_t> {
+      throw Exception(Exception::Type::illegalInstruction, "Native failure");
+    });
+    e = call(0x04, 0);
+    REQUIRE(e.er == ExitReason::returned);
+    CHECK(e.output[0x3f] == 0x00);
+    CHECK(e.output[0x5f] == 0);
+
+    // Unregistered standard addresses are not treated as empty accounts
+    CHECK(natives.remove(0x04));
+    e = call(0x04, 0);
+    CHECK(e.er == ExitReason::threw);
+    CHECK(e.ex == Exception::Type::notImplemented);
+
+    // Before Byzantium, 0x05 is a plain empty account, so CALLing it
+    // succeeds and leaves the output region untouched
+    Processor homestead(gs, nullptr, Fork::homestead);
+    CHECK(!homestead.get_native_contracts().find(0x05));
+    e = call_on(homestead, 0x05, 0xff);
+    REQUIRE(e.er == ExitReason::returned);
+    CHECK(e.output[0x3f] == 0x00);
+    CHECK(e.output[0x5f] == 1);
+
+    // Extensions may live outside the standard range, and see the caller's
+    // memory directly
+    struct Reverse : public NativeContract
+    {
+      const uint8_t* last_input = nullptr;
+
+      uint64_t gas(ByteView input) const override
+      {
+        return input.size();
+      }
+
+      void execute(ByteView input, NativeOutput& output) override
+      {
+        last_input = input.data();
+        std::vector<uint8_t> out(input.begin(), input.end());
+        std::reverse(out.begin(), out.end());
+        output.write(out);
+      }
+    };
+    const auto reverse = std::make_shared<Reverse>();
+    natives.add(0xee, reverse);
+
+    e = call(0xee, 0x20);
+    REQUIRE(e.er == ExitReason::returned);
+    CHECK(e.output[0x20] == 0x42);
+    CHECK(e.output[0x5f] == 1);
+    CHECK(reverse->last_input != nullptr);
+
+    e = call(0xee, 0x1f);
+    REQUIRE(e.er == ExitReason::returned);
+    CHECK(e.output[0x5f] == 0);
+
+    // As above, but with the output region over the input
+    const auto call_in_place = [&](uint8_t addr) {
+      const std::vector<uint8_t> code = {
+        Opcode::PUSH1, 0x42, Opcode::PUSH1, 0x00, Opcode::MSTORE,
+        Opcode::PUSH1, 0x20, Opcode::PUSH1, 0x00, Opcode::PUSH1,
+        0x20,          Opcode::PUSH1, 0x00, Opcode::PUSH1, 0x00,
+        Opcode::PUSH1, addr, Opcode::PUSH1, 0xff, Opcode::CALL,
+        Opcode::PUSH1, 0x40, Opcode::MSTORE, Opcode::PUSH1, 0x60,
+        Opcode::PUSH1, 0x00, Opcode::RETURN};
+      caller += 1;
+      gs.create(caller, {}, code);
+      return p.run(tx, from, gs.get(caller), {}, 0);
+    };
+
+    // Output is only copied out once the contract has returned, so it reads
+    // its input intact...
+    struct ReverseBytewise : public NativeContract
+    {
+      uint64_t gas(ByteView) const override
+      {
+        return 0;
+      }
+
+      void execute(ByteView input, NativeOutput& output) override
+      {
+        for (auto i = input.size(); i-- > 0;)
+        {
+          const uint8_t b = input[i];
+          output.write({&b, 1});
+        }
+      }
+    };
+    natives.add(0xef, std::make_shared<ReverseBytewise>());
+    e = call_in_place(0xef);
+    REQUIRE(e.er == ExitReason::returned);
+    CHECK(e.output[0x00] == 0x42);
+    CHECK(e.output[0x1f] == 0);
+    CHECK(e.output[0x5f] == 1);
+
+    // ...and a contract which fails after writing leaves the region as it
+    // was
+    struct WriteThenThrow : public NativeContract
+    {
+      uint64_t gas(ByteView) const override
+      {
+        return 0;
+      }
+
+      void execute(ByteView input, NativeOutput& output) override
+      {
+        const std::vector<uint8_t> junk(input.size(), 0xff);
+        output.write(junk);
+        throw Exception(Exception::Type::outOfBounds, "Late failure");
+      }
+    };
+    natives.add(0xf0, std::make_shared<WriteThenThrow>());
+    e = call_in_place(0xf0);
+    REQUIRE(e.er == ExitReason::returned);
+    CHECK(e.output[0x00] == 0);
+    CHECK(e.output[0x1f] == 0x42);
+    CHECK(e.output[0x5f] == 0);
+  }
+
+  SUBCASE("push, dup, swap and log families")
+  {
+    uint256_t addr = 0x6000;
+    const auto run_word = [&](const std::vector<uint8_t>& prefix) {
+      std::vector<uint8_t> code = prefix;
+      code.insert(
+        code.end(),
+        {Opcode::PUSH1,
+         0x00,
+         Opcode::MSTORE,
+         Opcode::PUSH1,
+         0x20,
+         Opcode::PUSH1,
+         0x00,
+         Opcode::RETURN});
+      addr += 1;
+      gs.create(addr, {}, code);
+      const auto e = p.run(tx, from, gs.get(addr), {}, 0);
+      REQUIRE(e.er == ExitReason::returned);
+      return from_big_endian(e.output.data(), 32u);
+    };
+
+    for (uint8_t n = 1; n <= 32; ++n)
+    {
+      std::vector<uint8_t> code = {uint8_t(Opcode::PUSH1 + n - 1)};
+      for (uint8_t i = 0; i < n; ++i)
+        code.push_back(0xa0 + i);
+      CHECK(run_word(code) == from_big_endian(code.data() + 1, n));
+    }
+
+    // Values 1 to 17 on the stack, with 17 on top
+    std::vector<uint8_t> values;
+    for (uint8_t i = 1; i <= 17; ++i)
+      values.insert(values.end(), {Opcode::PUSH1, i});
+    for (uint8_t n = 1; n <= 16; ++n)
+    {
+      auto code = values;
+      code.push_back(Opcode::DUP1 + n - 1);
+      CHECK(run_word(code) == 18 - n);
+
+      code = values;
+      code.push_back(Opcode::SWAP1 + n - 1);
+      CHECK(run_word(code) == 17 - n);
+    }
+
+    VectorLogHandler logs;
+    Transaction log_tx(from, logs);
+    for (uint8_t n = 0; n <= 4; ++n)
+    {
+      std::vector<uint8_t> code;
+      for (uint8_t i = 0; i < n; ++i)
+        code.insert(code.end(), {Opcode::PUSH1, uint8_t(0x10 + i)});
+      code.insert(
+        code.end(),
+        {Opcode::PUSH1, 0x00, Opcode::PUSH1, 0x00, uint8_t(Opcode::LOG0 + n)});
+      addr += 1;
+      gs.create(addr, {}, code);
+      p.run(log_tx, from, gs.get(addr), {}, 0);
+      REQUIRE(logs.logs.size() == n + 1u);
+      const auto& topics = logs.logs.back().topics;
+      REQUIRE(topics.size() == n);
+      for (uint8_t i = 0; i < n; ++i)
+        CHECK(topics[i] == 0x10 + n - 1 - i);
+    }
+  }
+
+  SUBCASE("superinstructions")
+  {
+    // Contains each fused sequence. Traced runs execute every instruction
+    // individually, so must agree with untraced runs.
+    const std::vector<uint8_t> code = {
+      Opcode::PUSH1, 0x05, Opcode::PUSH1, 0x20, Opcode::ADD, // 0x25
+      Opcode::DUP1, Opcode::PUSH1, 0xf0, Opcode::AND, // 0x20
+      Opcode::SWAP1, Opcode::POP, // drop 0x25
+      Opcode::PUSH1, 0x01, Opcode::PUSH1, 0x13, Opcode::JUMPI, // taken
+      Opcode::INVALID, Opcode::INVALID, Opcode::INVALID,
+      Opcode::JUMPDEST, // 0x13
+      Opcode::PUSH1, 0x00, Opcode::PUSH1, 0x13, Opcode::JUMPI, // not taken
+      Opcode::PUSH1, 0x1d, Opcode::JUMP, Opcode::INVALID,
+      Opcode::JUMPDEST, // 0x1d
+      Opcode::PUSH1, 0x00, Opcode::MSTORE, Opcode::PUSH1, 0x20,
+      Opcode::PUSH1, 0x00, Opcode::RETURN};
+    gs.create(to, {}, code);
+
+    const auto e = p.run(tx, from, gs.get(to), {}, 0);
+    REQUIRE(e.er == ExitReason::returned);
+    CHECK(from_big_endian(e.output.data(), e.output.size()) == 0x20);
+
+    Trace tr;
+    const auto traced = p.run(tx, from, gs.get(to), {}, 0, &tr);
+    CHECK(traced.er == e.er);
+    CHECK(traced.output == e.output);
+
+    // Statically invalid destinations still fail at runtime
+    const std::vector<uint8_t> bad_jump = {
+      Opcode::PUSH1, 0x03, Opcode::JUMP, Opcode::STOP};
+    const Address jumper(0x102);
+    gs.create(jumper, {}, bad_jump);
+    const auto b = p.run(tx, from, gs.get(jumper), {}, 0);
+    CHECK(b.er == ExitReason::threw);
+    CHECK(b.ex == Exception::Type::illegalInstruction);
+  }
+
+  SUBCASE("analysis cache")
+  {
+    // Code is cached once it has run more than the threshold
+    const std::vector<uint8_t> nop = {Opcode::PUSH1, 0x01, Opcode::STOP};
+    gs.create(to, {}, nop);
+    p.set_analysis_cache_threshold(2);
+    p.run(tx, from, gs.get(to), {}, 0);
+    p.run(tx, from, gs.get(to), {}, 0);
+    CHECK(p.num_cached_programs() == 0);
+    p.run(tx, from, gs.get(to), {}, 0);
+    CHECK(p.num_cached_programs() == 1);
+
+    // Other accounts holding the same code share its cached program
+    const Address copy(0xa000);
+    gs.create(copy, {}, nop);
+    p.run(tx, from, gs.get(copy), {}, 0);
+    CHECK(p.num_cached_programs() == 1);
+
+    // Past the bound, the least recently used program is evicted to make
+    // room for another
+    Processor bounded(gs);
+    bounded.set_analysis_cache_threshold(0);
+    const auto run_distinct = [&](uint64_t i) {
+      const Address addr(0xa100 + i);
+      if (!gs.exists(addr))
+        gs.create(
+          addr, {}, {Opcode::PUSH2, uint8_t(i >> 8), uint8_t(i), Opcode::STOP});
+      bounded.run(tx, from, gs.get(addr), {}, 0);
+    };
+    constexpr auto max = Processor::MAX_CACHED_PROGRAMS;
+    for (uint64_t i = 0; i < max; ++i)
+      run_distinct(i);
+    CHECK(bounded.num_cached_programs() == max);
+    CHECK(bounded.num_cache_fills() == max);
+
+    run_distinct(0);
+    CHECK(bounded.num_cache_fills() == max);
+    run_distinct(max);
+    CHECK(bounded.num_cached_programs() == max);
+    CHECK(bounded.num_cache_fills() == max + 1);
+    // 0 was used more recently than 1, so 1 was evicted
+    run_distinct(0);
+    CHECK(bounded.num_cache_fills() == max + 1);
+    run_distinct(1);
+    CHECK(bounded.num_cache_fills() == max + 2);
+
+    // Code of accounts which do not hold its hash is only hashed once, when
+    // it is cached, and is re-analysed if it changes
+    struct Unhashed : public Account
+    {
+      SimpleAccount inner;
+      mutable size_t hashes = 0;
+
+      Unhashed(const Address& a, const Code& c) : inner(a, 0, c) {}
+
+      Address get_address() const override
+      {
+        return inner.get_address();
+      }
+
+      uint256_t get_balance() const override
+      {
+        return inner.get_balance();
+      }
+
+      void set_balance(const uint256_t& b) override
+      {
+        inner.set_balance(b);
+      }
+
+      Nonce get_nonce() const override
+      {
+        return inner.get_nonce();
+      }
+
+      void increment_nonce() override
+      {
+        inner.increment_nonce();
+      }
+
+      Code get_code() const override
+      {
+        return inner.get_code();
+      }
+
+      void set_code(Code&& c) override
+      {
+        inner.set_code(std::move(c));
+      }
+
+      uint256_t get_code_hash() const override
+      {
+        ++hashes;
+        return Account::get_code_hash();
+      }
+    };
+
+    const auto returns = [](uint8_t v) {
+      return Code{Opcode::PUSH1,
+                  v,
+                  Opcode::PUSH1,
+                  0x00,
+                  Opcode::MSTORE8,
+                  Opcode::PUSH1,
+                  0x01,
+                  Opcode::PUSH1,
+                  0x00,
+                  Opcode::RETURN};
+    };
+    Unhashed unhashed(0xa200, returns(1));
+    SimpleStorage unhashed_st;
+    Processor by_address(gs);
+    by_address.set_analysis_cache_threshold(2);
+    const auto run_unhashed = [&]() {
+      const auto e = by_address.run(
+        tx, from, AccountState(unhashed, unhashed_st), {}, 0);
+      REQUIRE(e.output.size() == 1);
+      return e.output[0];
+    };
+
+    for (size_t i = 0; i < 6; ++i)
+      CHECK(run_unhashed() == 1);
+    CHECK(by_address.num_cache_fills() == 1);
+    CHECK(unhashed.hashes == 1);
+
+    unhashed.set_code(returns(2));
+    for (size_t i = 0; i < 6; ++i)
+      CHECK(run_unhashed() == 2);
+    CHECK(by_address.num_cache_fills() == 2);
+    CHECK(unhashed.hashes == 2);
+
+    // Differential test of random programs, with only forward jumps so that
+    // they always terminate
+    Processor cached(gs);
+    cached.set_analysis_cache_threshold(0);
+    Processor interpreted(gs);
+    interpreted.set_analysis_cache_threshold(Processor::NEVER_CACHE);
+
+    const std::vector<uint8_t> ops = {Opcode::ADD,
+                                      Opcode::SUB,
+                                      Opcode::MUL,
+                                      Opcode::AND,
+                                      Opcode::LT,
+                                      Opcode::ISZERO,
+                                      Opcode::DUP1,
+                                      Opcode::DUP3,
+                                      Opcode::SWAP1,
+                                      Opcode::SWAP2,
+                                      Opcode::POP,
+                                      Opcode::JUMPDEST};
+    std::mt19937 rng(42);
+    constexpr size_t num_programs = 100;
+    for (size_t i = 0; i < num_programs; ++i)
+    {
+      std::vector<uint8_t> code;
+      for (size_t j = 0; j < 16; ++j)
+      {
+        code.push_back(Opcode::PUSH1);
+        code.push_back(static_cast<uint8_t>(rng()));
+      }
+      std::vector<size_t> targets;
+      while (code.size() < 200)
+      {
+        switch (rng() % 4)
+        {
+          case 0:
+          {
+            const uint8_t n = 1 + rng() % 4;
+            code.push_back(Opcode::PUSH1 + n - 1);
+            for (uint8_t j = 0; j < n; ++j)
+              code.push_back(static_cast<uint8_t>(rng()));
+            break;
+          }
+          case 1:
+            code.push_back(ops[rng() % ops.size()]);
+            break;
+          case 2:
+            code.push_back(Opcode::PUSH1);
+            targets.push_back(code.size());
+            code.push_back(0);
+            code.push_back(rng() % 2 ? Opcode::JUMP : Opcode::JUMPI);
+            break;
+          default:
+            code.push_back(Opcode::JUMPDEST);
+        }
+      }
+      const std::vector<uint8_t> ret = {Opcode::JUMPDEST,
+                                        Opcode::PUSH1,
+                                        0x00,
+                                        Opcode::MSTORE,
+                                        Opcode::PUSH1,
+                                        0x20,
+                                        Opcode::PUSH1,
+                                        0x00,
+                                        Opcode::RETURN};
+      code.insert(code.end(), ret.begin(), ret.end());
+
+      // Jump to a later JUMPDEST (or occasionally, an invalid destination)
+      for (const auto t : targets)
+      {
+        std::vector<size_t> dests;
+        for (auto d = t + 2; d < code.size(); ++d)
+          if (code[d] == Opcode::JUMPDEST)
+            dests.push_back(d);
+        const auto d = rng() % 8 ? dests[rng() % dests.size()] : t + 2;
+        code[t] = static_cast<uint8_t>(d);
+      }
+
+      const Address addr(0x1000 + i);
+      gs.create(addr, {}, code);
+      const auto expected = interpreted.run(tx, from, gs.get(addr), {}, 0);
+      const auto actual = cached.run(tx, from, gs.get(addr), {}, 0);
+      CHECK(actual.er == expected.er);
+      CHECK(actual.ex == expected.ex);
+      CHECK(actual.exmsg() == expected.exmsg());
+      CHECK(actual.output == expected.output);
+    }
+    CHECK(cached.num_cached_programs() == num_programs);
+    CHECK(interpreted.num_cached_programs() == 0);
+  }
+
+  SUBCASE("small value fast paths")
+  {
+    // Differential test of arithmetic and comparisons against intx, with
+    // operands either side of the 64-bit boundary. Each program applies an
+    // opcode to two words of calldata.
+    using Reference = std::function<uint256_t(uint256_t, uint256_t)>;
+    const std::vector<std::pair<Opcode, Reference>> ops = {
+      {Opcode::ADD, [](uint256_t x, uint256_t y) { return x + y; }},
+      {Opcode::SUB, [](uint256_t x, uint256_t y) { return x - y; }},
+      {Opcode::MUL, [](uint256_t x, uint256_t y) { return x * y; }},
+      {Opcode::DIV,
+       [](uint256_t x, uint256_t y) { return y ? x / y : uint256_t(0); }},
+      {Opcode::MOD,
+       [](uint256_t x, uint256_t y) { return y ? x % y : uint256_t(0); }},
+      {Opcode::LT, [](uint256_t x, uint256_t y) { return uint256_t(x < y); }},
+      {Opcode::GT, [](uint256_t x, uint256_t y) { return uint256_t(x > y); }},
+      {Opcode::EQ, [](uint256_t x, uint256_t y) { return uint256_t(x == y); }},
+      {Opcode::ISZERO,
+       [](uint256_t x, uint256_t) { return uint256_t(x == 0); }}};
+
+    std::mt19937_64 rng(34);
+    const auto random_word = [&]() -> uint256_t {
+      switch (rng() % 5)
+      {
+        case 0:
+          return rng() % 4;
+        case 1:
+          return rng();
+        case 2:
+          return uint256_t(std::numeric_limits<uint64_t>::max()) - 2 +
+            rng() % 4;
+        case 3:
+          return {intx::uint128{rng(), rng()}, intx::uint128{rng(), rng()}};
+        default:
+          return uint256_t(0) - (rng() % 4);
+      }
+    };
+
+    uint256_t addr = 0x1000;
+    for (const auto& [op, reference] : ops)
+    {
+      const std::vector<uint8_t> code = {Opcode::PUSH1,
+                                         0x20,
+                                         Opcode::CALLDATALOAD,
+                                         Opcode::PUSH1,
+                                         0x00,
+                                         Opcode::CALLDATALOAD,
+                                         op,
+                                         Opcode::PUSH1,
+                                         0x00,
+                                         Opcode::MSTORE,
+                                         Opcode::PUSH1,
+                                         0x20,
+                                         Opcode::PUSH1,
+                                         0x00,
+                                         Opcode::RETURN};
+      addr += 1;
+      gs.create(addr, {}, code);
+
+      for (size_t i = 0; i < 200; ++i)
+      {
+        const auto x = random_word();
+        const auto y = random_word();
+        std::vector<uint8_t> input(64);
+        to_big_endian(x, input.data());
+        to_big_endian(y, input.data() + 32);
+
+        const auto e = p.run(tx, from, gs.get(addr), input, 0);
+        REQUIRE(e.er == ExitReason::returned);
+        CHECK(from_big_endian(e.output.data(), 32u) == reference(x, y));
+      }
+    }
+
+    // pop64 rejects any value of 2^64 or more
+    const std::vector<uint8_t> mload = {
+      Opcode::PUSH1, 0x00, Opcode::CALLDATALOAD, Opcode::MLOAD};
+    addr += 1;
+    gs.create(addr, {}, mload);
+    std::vector<uint8_t> input(32);
+    to_big_endian(uint256_t(1) << 64, input.data());
+    const auto e = p.run(tx, from, gs.get(addr), input, 0);
+    CHECK(e.er == ExitReason::threw);
+    CHECK(e.ex == Exception::Type::outOfBounds);
+  }
+
+  SUBCASE("modular arithmetic")
+  {
+    // Differential test of ADDMOD, MULMOD and EXP against intx. Each program
+    // applies an opcode to three words of calldata: x, y and m.
+    using Reference = std::function<uint256_t(uint256_t, uint256_t, uint256_t)>;
+    const std::vector<std::pair<Opcode, Reference>> ops = {
+      {Opcode::ADDMOD,
+       [](uint256_t x, uint256_t y, uint256_t m) {
+         return m ? intx::addmod(x, y, m) : uint256_t(0);
+       }},
+      {Opcode::MULMOD,
+       [](uint256_t x, uint256_t y, uint256_t m) {
+         return m ? intx::mulmod(x, y, m) : uint256_t(0);
+       }},
+      {Opcode::EXP,
+       [](uint256_t x, uint256_t y, uint256_t) { return intx::exp(x, y); }}};
+
+    std::mt19937_64 rng(35);
+    const auto random_word = [&]() -> uint256_t {
+      switch (rng() % 5)
+      {
+        case 0:
+          return rng() % 4;
+        case 1:
+          return rng();
+        case 2:
+          return uint256_t(1) << (rng() % 256);
+        case 3:
+          return {intx::uint128{rng(), rng()}, intx::uint128{rng(), rng()}};
+        default:
+          return uint256_t(0) - (rng() % 4);
+      }
+    };
+
+    // Moduli recur, so that a cached reduction is reused as well as replaced
+    std::vector<uint256_t> moduli = {0,
+                                     1,
+                                     7,
+                                     uint256_t(1) << 64,
+                                     uint256_t(1) << 255,
+                                     uint256_t(0) - 1};
+    for (size_t i = 0; i < 8; ++i)
+    {
+      moduli.push_back(random_word());
+      moduli.push_back(random_word() >> (rng() % 256));
+    }
+
+    uint256_t addr = 0x2000;
+    for (const auto& [op, reference] : ops)
+    {
+      const std::vector<uint8_t> code = {Opcode::PUSH1,
+                                         0x40,
+                                         Opcode::CALLDATALOAD,
+                                         Opcode::PUSH1,
+                                         0x20,
+                                         Opcode::CALLDATALOAD,
+                                         Opcode::PUSH1,
+                                         0x00,
+                                         Opcode::CALLDATALOAD,
+                                         op,
+                                         Opcode::PUSH1,
+                                         0x00,
+                                         Opcode::MSTORE,
+                                         Opcode::PUSH1,
+                                         0x20,
+                                         Opcode::PUSH1,
+                                         0x00,
+                                         Opcode::RETURN};
+      addr += 1;
+      gs.create(addr, {}, code);
+
+      for (size_t i = 0; i < 300; ++i)
+      {
+        const auto x = random_word();
+        const auto y = random_word();
+        const auto m = moduli[rng() % moduli.size()];
+        std::vector<uint8_t> input(96);
+        to_big_endian(x, input.data());
+        to_big_endian(y, input.data() + 32);
+        to_big_endian(m, input.data() + 64);
+
+        const auto e = p.run(tx, from, gs.get(addr), input, 0);
+        REQUIRE(e.er == ExitReason::returned);
+        CHECK(from_big_endian(e.output.data(), 32u) == reference(x, y, m));
+      }
+    }
+  }
+  SUBCASE("shifts")
+  {
+    // 1 << 4, 0xff >> 4, -16 >> 2 (arithmetic), -16 >> 300 (arithmetic)
+    const std::vector<uint8_t> code = {
+      Opcode::PUSH1, 0x01, Opcode::PUSH1, 0x04, Opcode::SHL,
+      Opcode::PUSH1, 0x00, Opcode::MSTORE, Opcode::PUSH1, 0xff,
+      Opcode::PUSH1, 0x04, Opcode::SHR, Opcode::PUSH1, 0x20,
+      Opcode::MSTORE, Opcode::PUSH1, 0x10, Opcode::PUSH1, 0x00,
+      Opcode::SUB, Opcode::PUSH1, 0x02, Opcode::SAR, Opcode::PUSH1,
+      0x40, Opcode::MSTORE, Opcode::PUSH1, 0x10, Opcode::PUSH1,
+      0x00, Opcode::SUB, Opcode::PUSH2, 0x01, 0x2c,
+      Opcode::SAR, Opcode::PUSH1, 0x60, Opcode::MSTORE, Opcode::PUSH1,
+      0x80, Opcode::PUSH1, 0x00, Opcode::RETURN};
+    gs.create(to, {}, code);
+
+    const auto e = p.run(tx, from, gs.get(to), {}, 0);
+    REQUIRE(e.er == ExitReason::returned);
+    REQUIRE(e.output.size() == 0x80);
+
+    const auto word = [&](size_t i) {
+      return from_big_endian(e.output.data() + 32 * i, 32u);
+    };
+    CHECK(word(0) == 0x10);
+    CHECK(word(1) == 0x0f);
+    CHECK(word(2) == uint256_t(0) - 4);
+    CHECK(word(3) == ~uint256_t(0));
+
+    // Shifts were introduced in Constantinople
+    Processor hp(gs, nullptr, Fork::byzantium);
+    const auto h = hp.run(tx, from, gs.get(to), {}, 0);
+    CHECK(h.er == ExitReason::threw);
+    CHECK(h.ex == Exception::Type::illegalInstruction);
+  }
+
+  SUBCASE("call allocations")
+  {
+    // Callee stores a word to memory and returns it
+    const std::vector<uint8_t> callee_code = {Opcode::PUSH1,
+                                              0x2a,
+                                              Opcode::PUSH1,
+                                              0x00,
+                                              Opcode::MSTORE,
+                                              Opcode::PUSH1,
+                                              0x20,
+                                              Opcode::PUSH1,
+                                              0x00,
+                                              Opcode::RETURN};
+    const Address callee(0x4000);
+    gs.create(callee, {}, callee_code);
+
+    // Caller makes n calls, each passing size bytes of its memory as input
+    uint256_t caller = 0x4000;
+    const auto make_caller = [&](size_t n, uint16_t size) {
+      std::vector<uint8_t> code;
+      for (size_t i = 0; i < n; ++i)
+      {
+        code.insert(
+          code.end(),
+          {Opcode::PUSH1,
+           0x20,
+           Opcode::PUSH1,
+           0x00,
+           Opcode::PUSH2,
+           uint8_t(size >> 8),
+           uint8_t(size),
+           Opcode::PUSH1,
+           0x00,
+           Opcode::PUSH1,
+           0x00,
+           Opcode::PUSH2,
+           0x40,
+           0x00,
+           Opcode::GAS,
+           Opcode::CALL,
+           Opcode::POP});
+      }
+      caller += 1;
+      gs.create(caller, {}, code);
+      return caller;
+    };
+
+    const auto count = [&](const Address& addr) {
+      // Once to warm caches, and then counted
+      p.run(tx, from, gs.get(addr), {}, 0);
+      const size_t before = allocations;
+      const auto e = p.run(tx, from, gs.get(addr), {}, 0);
+      const size_t after = allocations;
+      REQUIRE(e.er == ExitReason::halted);
+      return after - before;
+    };
+
+    // Each call allocates its frame and its stack, and nothing else: in
+    // particular, nothing which depends on the input size
+    p.set_analysis_cache_threshold(0);
+    const auto one = count(make_caller(1, 32));
+    const auto many = count(make_caller(11, 32));
+    const auto large = count(make_caller(11, 4096));
+    CHECK(many - one == 10 * 2);
+    CHECK(large == many);
+  }
+
+  SUBCASE("faults")
+  {
+    // Messages are still formatted, when read
+    const std::vector<uint8_t> bad_jump = {
+      Opcode::PUSH1, 0x05, Opcode::JUMP, Opcode::STOP};
+    gs.create(to, {}, bad_jump);
+    auto e = p.run(tx, from, gs.get(to), {}, 0);
+    CHECK(e.er == ExitReason::threw);
+    CHECK(e.ex == Exception::Type::illegalInstruction);
+    CHECK(e.expc == 2);
+    CHECK(e.exop == Opcode::JUMP);
+    CHECK(e.error.operand(0) == 5);
+    CHECK(e.exmsg() == "5 is not a jump destination");
+
+    const auto underflow = Address(0x5000);
+    gs.create(underflow, {}, {Opcode::PUSH1, 0x01, Opcode::ADD});
+    e = p.run(tx, from, gs.get(underflow), {}, 0);
+    CHECK(e.er == ExitReason::threw);
+    CHECK(e.exmsg() == "Stack out of range");
+
+    // Operands too large for 64 bits are reported with their value
+    const auto too_large = Address(0x5001);
+    gs.create(
+      too_large,
+      {},
+      {Opcode::PUSH9, 1, 0, 0, 0, 0, 0, 0, 0, 0, Opcode::MLOAD});
+    e = p.run(tx, from, gs.get(too_large), {}, 0);
+    CHECK(e.ex == Exception::Type::outOfBounds);
+    CHECK(
+      e.exmsg() == "Value on stack is larger than 2^64 (0x1"
+                        "0000000000000000)");
+
+    // Unknown opcodes are reported with the address of their code
+    const auto unknown = Address(0x5002);
+    gs.create(unknown, {}, {Opcode::PUSH1, 0x01, 0x0c});
+    e = p.run(tx, from, gs.get(unknown), {}, 0);
+    CHECK(e.ex == Exception::Type::illegalInstruction);
+    CHECK(
+      e.exmsg() ==
+      "Unknown/unsupported Opcode: 0x0c at position 2 of "
+      "0x0000000000000000000000000000000000005002, call-depth 1");
+
+    // As are payments the payer cannot afford
+    const auto broke = Address(0x5003);
+    gs.create(
+      broke,
+      {},
+      {Opcode::PUSH1,
+       0x00,
+       Opcode::PUSH1,
+       0x00,
+       Opcode::PUSH1,
+       0x00,
+       Opcode::PUSH1,
+       0x00,
+       Opcode::PUSH1,
+       0x01,
+       Opcode::PUSH1,
+       0xab,
+       Opcode::GAS,
+       Opcode::CALL});
+    e = p.run(tx, from, gs.get(broke), {}, 0);
+    CHECK(e.ex == Exception::Type::outOfFunds);
+    CHECK(
+      e.exmsg() ==
+      "Insufficient funds to pay 0x00000000000000000000000000000000000000ab "
+      "at position 13, call-depth 1");
+
+    // A callee which faults costs its caller no more allocations than one
+    // which halts
+    const auto count = [&](uint8_t id, const std::vector<uint8_t>& code) {
+      const uint256_t callee = 0x5100 + id;
+      gs.create(callee, {}, code);
+      const Address caller(0x5200 + id);
+      gs.create(
+        caller,
+        {},
+        {Opcode::PUSH1,
+         0x00,
+         Opcode::PUSH1,
+         0x00,
+         Opcode::PUSH1,
+         0x00,
+         Opcode::PUSH1,
+         0x00,
+         Opcode::PUSH1,
+         0x00,
+         Opcode::PUSH2,
+         uint8_t(callee >> 8),
+         uint8_t(callee),
+         Opcode::GAS,
+         Opcode::CALL,
+         Opcode::STOP});
+
+      p.run(tx, from, gs.get(caller), {}, 0);
+      const size_t before = allocations;
+      p.run(tx, from, gs.get(caller), {}, 0);
+      return allocations - before;
+    };
+    const auto halts = count(0, {Opcode::STOP});
+    CHECK(count(1, {Opcode::INVALID}) == halts);
+    // Including the faults of an operand too large for 64 bits, and of a
+    // payment the callee cannot afford
+    CHECK(
+      count(
+        2,
+        {Opcode::PUSH9, 1, 0, 0, 0, 0, 0, 0, 0, 0, Opcode::MLOAD}) == halts);
+    CHECK(
+      count(
+        3,
+        {Opcode::PUSH1,
+         0x00,
+         Opcode::PUSH1,
+         0x00,
+         Opcode::PUSH1,
+         0x00,
+         Opcode::PUSH1,
+         0x00,
+         Opcode::PUSH1,
+         0x01,
+         Opcode::PUSH1,
+         0x00,
+         Opcode::GAS,
+         Opcode::CALL}) == halts);
+
+    // Nor does a fault in the outermost frame, whose message is not formatted
+    // until it is read
+    const auto count_outer = [&](uint8_t op) {
+      const Address addr(0x5300 + op);
+      gs.create(addr, {}, {op});
+      p.run(tx, from, gs.get(addr), {}, 0);
+      const size_t before = allocations;
+      p.run(tx, from, gs.get(addr), {}, 0);
+      return allocations - before;
+    };
+    CHECK(count_outer(Opcode::INVALID) == count_outer(Opcode::STOP));
+
+    // Memory faults are raised before the instruction has any effect, so a
+    // CALL whose output region is out of range transfers nothing
+    const Address payee(0x5400);
+    gs.create(payee, {}, {Opcode::STOP});
+    const Address payer(0x5401);
+    gs.create(
+      payer,
+      10,
+      {Opcode::PUSH1,
+       0x01,
+       Opcode::PUSH4,
+       0xff,
+       0xff,
+       0xff,
+       0xff,
+       Opcode::PUSH1,
+       0x00,
+       Opcode::PUSH1,
+       0x00,
+       Opcode::PUSH1,
+       0x05,
+       Opcode::PUSH2,
+       0x54,
+       0x00,
+       Opcode::GAS,
+       Opcode::CALL,
+       Opcode::STOP});
+    e = p.run(tx, from, gs.get(payer), {}, 0);
+    CHECK(e.er == ExitReason::threw);
+    CHECK(e.ex == Exception::Type::outOfBounds);
+    CHECK(e.exmsg() == "Memory limit exceeded (4294967296 > 33554432)");
+    CHECK(gs.get_balance(payer) == 10);
+    CHECK(gs.get_balance(payee) == 0);
+  }
+
+  SUBCASE("stack bounds")
+  {
+    // Faults are reported at the instruction which meets them, even though
+    // bounds are checked once per basic block
+    const auto run = [&](const Address& addr, std::vector<uint8_t> code) {
+      gs.create(addr, {}, code);
+      const auto e = p.run(tx, from, gs.get(addr), {}, 0);
+      CHECK(e.er == ExitReason::threw);
+      CHECK(e.ex == Exception::Type::outOfBounds);
+      return e;
+    };
+
+    auto e = run(
+      0x7000,
+      {Opcode::PUSH1, 0x01, Opcode::PUSH1, 0x02, Opcode::ADD, Opcode::ADD});
+    CHECK(e.expc == 5);
+    CHECK(e.exmsg() == "Stack out of range");
+
+    e = run(0x7001, {Opcode::PUSH1, 0x01, Opcode::DUP2});
+    CHECK(e.expc == 2);
+    CHECK(e.exmsg() == "Dup out of range (1 >= 1)");
+
+    e = run(0x7002, {Opcode::PUSH1, 0x01, Opcode::SWAP1});
+    CHECK(e.expc == 2);
+    CHECK(e.exmsg() == "Swap out of range (1 >= 1)");
+
+    // A block which met its requirements is checked again when re-entered
+    e = run(
+      0x7003,
+      {Opcode::PUSH1,
+       0x01,
+       Opcode::PUSH1,
+       0x01,
+       Opcode::JUMPDEST,
+       Opcode::POP,
+       Opcode::PUSH1,
+       0x04,
+       Opcode::JUMP});
+    CHECK(e.expc == 5);
+    CHECK(e.exop == Opcode::POP);
+    CHECK(e.exmsg() == "Stack out of range");
+
+    // Each pass of this loop grows the stack by one, until its second push
+    // overflows
+    e = run(
+      0x7004,
+      {Opcode::JUMPDEST,
+       Opcode::PUSH1,
+       0x01,
+       Opcode::PUSH1,
+       0x00,
+       Opcode::JUMP});
+    CHECK(e.expc == 3);
+    CHECK(e.exmsg() == "Stack mem exceeded (1024 == 1024)");
+
+    // A PUSH cut short by the end of the code faults on that first, even
+    // with a full stack
+    std::vector<uint8_t> fill;
+    for (size_t i = 0; i < Stack::MAX_SIZE; ++i)
+      fill.insert(fill.end(), {Opcode::PUSH1, 0x00});
+    fill.insert(fill.end(), {Opcode::PUSH2, 0x00});
+    e = run(0x7005, fill);
+    CHECK(e.expc == 2 * Stack::MAX_SIZE);
+    CHECK(e.exmsg().find("Push immediate exceeds") == 0);
+  }
+
+  SUBCASE("selector dispatch")
+  {
+    // A Solidity-style dispatcher, whose targets each return a marker and
+    // the selector left on the stack. The second comparison with 0x11223344
+    // is never reached.
+    const std::vector<uint32_t> selectors = {
+      0xaabbccdd, 0x11223344, 0x11223344, 0x05};
+    const auto tail = [](std::vector<uint8_t>& c, uint8_t marker) {
+      c.insert(
+        c.end(),
+        {Opcode::PUSH1,
+         marker,
+         Opcode::PUSH1,
+         0x00,
+         Opcode::MSTORE,
+         Opcode::PUSH1,
+         0x20,
+         Opcode::MSTORE,
+         Opcode::PUSH1,
+         0x40,
+         Opcode::PUSH1,
+         0x00,
+         Opcode::RETURN});
+    };
+
+    std::vector<uint8_t> code = {Opcode::PUSH1,
+                                 0x00,
+                                 Opcode::CALLDATALOAD,
+                                 Opcode::PUSH1,
+                                 0xe0,
+                                 Opcode::SHR};
+    std::vector<size_t> dests;
+    for (const auto sel : selectors)
+    {
+      code.push_back(Opcode::DUP1);
+      if (sel <= 0xff)
+        code.insert(code.end(), {Opcode::PUSH1, uint8_t(sel)});
+      else
+        code.insert(
+          code.end(),
+          {Opcode::PUSH4,
+           uint8_t(sel >> 24),
+           uint8_t(sel >> 16),
+           uint8_t(sel >> 8),
+           uint8_t(sel)});
+      code.insert(code.end(), {Opcode::EQ, Opcode::PUSH1});
+      dests.push_back(code.size());
+      code.insert(code.end(), {0x00, Opcode::JUMPI});
+    }
+    tail(code, 0xff);
+    for (size_t i = 0; i < dests.size(); ++i)
+    {
+      code[dests[i]] = uint8_t(code.size());
+      code.push_back(Opcode::JUMPDEST);
+      tail(code, uint8_t(i));
+    }
+
+    const Address addr(0x8000);
+    gs.create(addr, {}, code);
+    Processor cached(gs);
+    cached.set_analysis_cache_threshold(0);
+    Processor interpreted(gs);
+    interpreted.set_analysis_cache_threshold(Processor::NEVER_CACHE);
+
+    const std::vector<std::pair<std::vector<uint8_t>, uint8_t>> calls = {
+      {{0xaa, 0xbb, 0xcc, 0xdd}, 0},
+      {{0x11, 0x22, 0x33, 0x44, 0x55}, 1},
+      {{0x00, 0x00, 0x00, 0x05}, 3},
+      {{0xde, 0xad, 0xbe, 0xef}, 0xff},
+      {{}, 0xff}};
+    for (const auto& [input, marker] : calls)
+    {
+      const auto e = cached.run(tx, from, gs.get(addr), input, 0);
+      REQUIRE(e.er == ExitReason::returned);
+      REQUIRE(e.output.size() == 64);
+      CHECK(e.output[31] == marker);
+
+      const auto expected = interpreted.run(tx, from, gs.get(addr), input, 0);
+      CHECK(e.output == expected.output);
+    }
+  }
+
+  SUBCASE("minimal proxies")
+  {
+    const auto clone = [](const Address& impl) {
+      auto code = to_bytes("0x363d3d373d3d3d363d73");
+      code.insert(code.end(), impl.data(), impl.data() + Address::SIZE);
+      const auto suffix = to_bytes("0x5af43d82803e903d91602b57fd5bf3");
+      code.insert(code.end(), suffix.begin(), suffix.end());
+      return code;
+    };
+
+    // Implementations which store their input and return the address and
+    // caller they ran with, halt, fault, and revert with data
+    const std::vector<std::vector<uint8_t>> impls = {
+      {Opcode::PUSH1,  0x00,          Opcode::CALLDATALOAD,
+       Opcode::PUSH1,  0x00,          Opcode::SSTORE,
+       Opcode::ADDRESS, Opcode::PUSH1, 0x00,
+       Opcode::MSTORE, Opcode::CALLER, Opcode::PUSH1,
+       0x20,           Opcode::MSTORE, Opcode::PUSH1,
+       0x40,           Opcode::PUSH1,  0x00,
+       Opcode::RETURN},
+      {Opcode::STOP},
+      {Opcode::INVALID},
+      {Opcode::PUSH1,
+       0x2a,
+       Opcode::PUSH1,
+       0x00,
+       Opcode::MSTORE,
+       Opcode::PUSH1,
+       0x20,
+       Opcode::PUSH1,
+       0x00,
+       Opcode::REVERT}};
+    const std::vector<ExitReason> reasons = {ExitReason::returned,
+                                             ExitReason::returned,
+                                             ExitReason::reverted,
+                                             ExitReason::reverted};
+
+    const std::vector<uint8_t> input(32, 0x07);
+    for (size_t i = 0; i < impls.size(); ++i)
+    {
+      const Address impl(0x9000 + i);
+      gs.create(impl, {}, impls[i]);
+      // A proxy, and a proxy of that proxy
+      const Address proxy(0x9100 + i);
+      gs.create(proxy, {}, clone(impl));
+      const Address outer(0x9200 + i);
+      gs.create(outer, {}, clone(proxy));
+
+      for (const auto& addr : {proxy, outer})
+      {
+        const auto e = p.run(tx, from, gs.get(addr), input, 0);
+        CHECK(e.er == reasons[i]);
+
+        // Traced runs execute the proxies' own instructions
+        Trace tr;
+        const auto expected = p.run(tx, from, gs.get(addr), input, 0, &tr);
+        CHECK(e.er == expected.er);
+        CHECK(e.output == expected.output);
+      }
+    }
+
+    // The implementation runs with the proxy's address and storage, and the
+    // proxy's caller
+    const auto e = p.run(tx, from, gs.get(0x9100), input, 0);
+    REQUIRE(e.output.size() == 64);
+    CHECK(from_big_endian(e.output.data()) == 0x9100);
+    CHECK(from_big_endian(e.output.data() + 32) == from);
+    CHECK(gs.get(0x9100).st.load(0) == from_big_endian(input.data()));
+    CHECK(gs.get(0x9000).st.load(0) == 0);
+
+    // Proxies' frames count towards the call depth. An implementation which
+    // counts its runs in storage and then calls its own proxy runs at every
+    // other depth, from 2 up to the limit, where its CALL faults.
+    const Address counter(0x9300);
+    const Address counter_proxy(0x9301);
+    gs.create(
+      counter,
+      {},
+      {Opcode::PUSH1, 0x00, Opcode::SLOAD, Opcode::PUSH1, 0x01,
+       Opcode::ADD,   Opcode::PUSH1, 0x00, Opcode::SSTORE, Opcode::PUSH1,
+       0x00,          Opcode::PUSH1, 0x00, Opcode::PUSH1, 0x00,
+       Opcode::PUSH1, 0x00,          Opcode::PUSH1, 0x00, Opcode::PUSH2,
+       0x93,          0x01,          Opcode::GAS, Opcode::CALL, Opcode::STOP});
+    gs.create(counter_proxy, {}, clone(counter));
+    for (const bool traced : {false, true})
+    {
+      Trace tr;
+      gs.get(counter_proxy).st.store(0, 0);
+      p.run(tx, from, gs.get(counter_proxy), {}, 0, traced ? &tr : nullptr);
+      CHECK(gs.get(counter_proxy).st.load(0) == 512);
+    }
+  }
+
+  SUBCASE("reads do not create accounts")
+  {
+    const Address probed(0xbeef);
+    const std::vector<uint8_t> code = {Opcode::PUSH2,
+                                       0xbe,
+                                       0xef,
+                                       Opcode::BALANCE,
+                                       Opcode::PUSH2,
+                                       0xbe,
+                                       0xef,
+                                       Opcode::EXTCODESIZE,
+                                       Opcode::PUSH2,
+                                       0xbe,
+                                       0xef,
+                                       Opcode::EXTCODEHASH,
+                                       Opcode::PUSH1,
+                                       0x20,
+                                       Opcode::PUSH1,
+                                       0x00,
+                                       Opcode::PUSH1,
+                                       0x00,
+                                       Opcode::PUSH2,
+                                       0xbe,
+                                       0xef,
+                                       Opcode::EXTCODECOPY,
+                                       Opcode::STOP};
+    const Address reader(0xb000);
+    gs.create(reader, {}, code);
+    const auto before = gs.num_accounts();
+
+    const auto e = p.run(tx, from, gs.get(reader), {}, 0);
+    CHECK(e.er == ExitReason::halted);
+    CHECK(gs.num_accounts() == before);
+    CHECK(!gs.exists(probed));
+
+    CHECK(gs.find(probed) == nullptr);
+    CHECK(gs.get_balance(probed) == 0);
+    CHECK(gs.get_code_size(probed) == 0);
+    CHECK(gs.get_code_hash(probed) == empty_code_hash());
+    CHECK(gs.find(reader) == &gs.get(reader).acc);
+    CHECK(gs.get_code_size(reader) == code.size());
+    CHECK(gs.num_accounts() == before);
+  }
+
+  SUBCASE("data passed through nested frames")
+  {
+    // Each proxy forwards its calldata to the next, and returns whatever
+    // that returned. The last echoes its calldata, or reverts with it.
+    for (const auto op : {Opcode::RETURN, Opcode::REVERT})
+    {
+      const std::vector<uint8_t> echo = {Opcode::CALLDATASIZE,
+                                         Opcode::PUSH1,
+                                         0x00,
+                                         Opcode::PUSH1,
+                                         0x00,
+                                         Opcode::CALLDATACOPY,
+                                         Opcode::CALLDATASIZE,
+                                         Opcode::PUSH1,
+                                         0x00,
+                                         op};
+      uint256_t next = op == Opcode::RETURN ? 0x3000 : 0x3100;
+      gs.create(next, {}, echo);
+
+      for (size_t i = 0; i < 3; ++i)
+      {
+        const std::vector<uint8_t> proxy = {
+          Opcode::CALLDATASIZE,   Opcode::PUSH1,
+          0x00,                   Opcode::PUSH1,
+          0x00,                   Opcode::CALLDATACOPY,
+          Opcode::PUSH1,          0x00,
+          Opcode::PUSH1,          0x00,
+          Opcode::CALLDATASIZE,   Opcode::PUSH1,
+          0x00,                   Opcode::PUSH1,
+          0x00,                   Opcode::PUSH2,
+          uint8_t(next >> 8),     uint8_t(next),
+          Opcode::GAS,            Opcode::CALL,
+          Opcode::POP,            Opcode::RETURNDATASIZE,
+          Opcode::PUSH1,          0x00,
+          Opcode::PUSH1,          0x00,
+          Opcode::RETURNDATACOPY, Opcode::RETURNDATASIZE,
+          Opcode::PUSH1,          0x00,
+          Opcode::RETURN};
+        next += 1;
+        gs.create(next, {}, proxy);
+      }
+
+      std::vector<uint8_t> input(10000);
+      for (size_t i = 0; i < input.size(); ++i)
+        input[i] = static_cast<uint8_t>(i * 13);
+
+      const auto e = p.run(tx, from, gs.get(next), input, 0);
+      REQUIRE(e.er == ExitReason::returned);
+      CHECK(e.output == input);
+    }
+  }
+
+  SUBCASE("revert and return data")
+  {
+    // Callee stores 0x2a and reverts with it
+    const std::vector<uint8_t> callee_code = {Opcode::PUSH1,
+                                              0x2a,
+                                              Opcode::PUSH1,
+                                              0x00,
+                                              Opcode::MSTORE,
+                                              Opcode::PUSH1,
+                                              0x20,
+                                              Opcode::PUSH1,
+                                              0x00,
+                                              Opcode::REVERT};
+    const Address callee(0x102);
+    gs.create(callee, {}, callee_code);
+
+    auto e = p.run(tx, from, gs.get(callee), {}, 0);
+    REQUIRE(e.er == ExitReason::reverted);
+    CHECK(e.output.size() == 0x20);
+    CHECK(e.output[0x1f] == 0x2a);
+
+    // Each fork runs its own instantiation of the interpreter; REVERT does
+    // not exist in Homestead
+    Processor hp(gs, nullptr, Fork::homestead);
+    CHECK(hp.run(tx, from, gs.get(callee), {}, 0).er == ExitReason::threw);
+
+    // Caller returns [out, success, RETURNDATASIZE, RETURNDATACOPY]
+    const std::vector<uint8_t> code = {
+      Opcode::PUSH1, 0x20, Opcode::PUSH1, 0x00, Opcode::PUSH1,
+      0x00, Opcode::PUSH1, 0x00, Opcode::PUSH1, 0x00,
+      Opcode::PUSH2, 0x01, 0x02, Opcode::PUSH1, 0x00,
+      Opcode::CALL, Opcode::PUSH1, 0x20, Opcode::MSTORE,
+      Opcode::RETURNDATASIZE, Opcode::PUSH1, 0x40, Opcode::MSTORE,
+      Opcode::PUSH1, 0x20, Opcode::PUSH1, 0x00, Opcode::PUSH1,
+      0x60, Opcode::RETURNDATACOPY, Opcode::PUSH1, 0x80, Opcode::PUSH1,
+      0x00, Opcode::RETURN};
+    gs.create(to, {}, code);
+
+    e = p.run(tx, from, gs.get(to), {}, 0);
+    REQUIRE(e.er == ExitReason::returned);
+    REQUIRE(e.output.size() == 0x80);
+    CHECK(e.output[0x1f] == 0x2a);
+    CHECK(e.output[0x3f] == 0);
+    CHECK(e.output[0x5f] == 0x20);
+    CHECK(e.output[0x7f] == 0x2a);
+
+    // Reading beyond the return data is an error
+    const std::vector<uint8_t> overread = {Opcode::PUSH1,
+                                           0x01,
+                                           Opcode::PUSH1,
+                                           0x00,
+                                           Opcode::PUSH1,
+                                           0x00,
+                                           Opcode::RETURNDATACOPY};
+    const Address reader(0x103);
+    gs.create(reader, {}, overread);
+    e = p.run(tx, from, gs.get(reader), {}, 0);
+    CHECK(e.er == ExitReason::threw);
+    CHECK(e.ex == Exception::Type::outOfBounds);
+  }
+
+  SUBCASE("staticcall")
+  {
+    // Callee writes to storage, so fails when called statically
+    const std::vector<uint8_t> callee_code = {
+      Opcode::PUSH1, 0x01, Opcode::PUSH1, 0x00, Opcode::SSTORE};
+    const Address callee(0x102);
+    gs.create(callee, {}, callee_code);
+
+    const std::vector<uint8_t> code = {
+      Opcode::PUSH1, 0x00, Opcode::PUSH1, 0x00, Opcode::PUSH1,
+      0x00, Opcode::PUSH1, 0x00, Opcode::PUSH2, 0x01,
+      0x02, Opcode::PUSH1, 0x00, Opcode::STATICCALL, Opcode::PUSH1,
+      0x00, Opcode::MSTORE, Opcode::PUSH1, 0x20, Opcode::PUSH1,
+      0x00, Opcode::RETURN};
+    gs.create(to, {}, code);
+
+    const auto e = p.run(tx, from, gs.get(to), {}, 0);
+    REQUIRE(e.er == ExitReason::returned);
+    CHECK(e.output[0x1f] == 0);
+    CHECK(gs.get(callee).st.load(0) == 0);
+
+    // Called directly, the write succeeds
+    p.run(tx, from, gs.get(callee), {}, 0);
+    CHECK(gs.get(callee).st.load(0) == 1);
+  }
+
+  SUBCASE("create2")
+  {
+    // Init code returns a single (zero) byte of code
+    const std::vector<uint8_t> init_code = {
+      Opcode::PUSH1, 0x01, Opcode::PUSH1, 0x00, Opcode::RETURN};
+
+    // CREATE2 twice with the same salt, then EXTCODEHASH the first result
+    std::vector<uint8_t> code = {Opcode::PUSH5};
+    code.insert(code.end(), init_code.begin(), init_code.end());
+    const std::vector<uint8_t> rest = {
+      Opcode::PUSH1, 0x00, Opcode::MSTORE, Opcode::PUSH1, 0x42,
+      Opcode::PUSH1, 0x05, Opcode::PUSH1, 0x1b, Opcode::PUSH1,
+      0x00, Opcode::CREATE2, Opcode::PUSH1, 0x20, Opcode::MSTORE,
+      Opcode::PUSH1, 0x42, Opcode::PUSH1, 0x05, Opcode::PUSH1,
+      0x1b, Opcode::PUSH1, 0x00, Opcode::CREATE2, Opcode::PUSH1,
+      0x40, Opcode::MSTORE, Opcode::PUSH1, 0x20, Opcode::MLOAD,
+      Opcode::EXTCODEHASH, Opcode::PUSH1, 0x60, Opcode::MSTORE,
+      Opcode::PUSH1, 0x60, Opcode::PUSH1, 0x20, Opcode::RETURN};
+    code.insert(code.end(), rest.begin(), rest.end());
+    gs.create(to, {}, code);
+
+    const auto e = p.run(tx, from, gs.get(to), {}, 0);
+    REQUIRE(e.er == ExitReason::returned);
+    REQUIRE(e.output.size() == 0x60);
+
+    const auto expected = generate_address(to, 0x42, init_code);
+    CHECK(from_big_endian(e.output.data(), 32u) == expected);
+    CHECK(gs.get(expected).acc.get_code() == std::vector<uint8_t>{0x00});
+
+    // The second creation collides with the first
+    CHECK(from_big_endian(e.output.data() + 32, 32u) == 0);
+
+    const auto code_hash = keccak_256(std::vector<uint8_t>{0x00});
+    CHECK(std::equal(
+      code_hash.begin(), code_hash.end(), e.output.begin() + 0x40));
   }
 }